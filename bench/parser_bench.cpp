@@ -0,0 +1,160 @@
+// Checks the /proc parsers on names that used to shift fields, then times them against the
+// istringstream parsing they replaced, over the stat, statm and io of every live process.
+//
+//   parser_bench [rounds]
+//
+// Exits 1 when a check fails.
+#include "../include/proc_parsers.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct StatCase {
+    const char* content;
+    const char* comm;
+    char state;
+    int ppid;
+    unsigned long long utime;
+    unsigned long long stime;
+    long numThreads;
+    unsigned long long startTime;
+};
+
+// comm is whatever the task called itself, up to 15 bytes: spaces and ')' included
+const StatCase STAT_CASES[] = {
+    {"4242 (a b) c)) S 17 4242 4242 0 -1 4194560 100 0 0 0 123 456 0 0 20 0 3 0 98765 1000 200\n", "a b) c)", 'S',
+     17, 123, 456, 3, 98765},
+    {"7 ((sd-pam)) R 1 7 7 0 -1 1077936448 5 0 0 0 11 22 0 0 20 0 1 0 333 0 0\n", "(sd-pam)", 'R', 1, 11, 22, 1, 333},
+    {"9 () Z 2 0 0 0 -1 0 0 0 0 0 0 0 0 0 20 0 1 0 7 0 0\n", "", 'Z', 2, 0, 0, 1, 7},
+    {"31 (Web Content) S 30 30 30 0 -1 0 0 0 0 0 9 8 0 0 20 0 41 0 5 0 0\n", "Web Content", 'S', 30, 9, 8, 41, 5},
+};
+
+int failures = 0;
+
+void check(bool ok, const char* what, const char* input) {
+    if (!ok) {
+        std::printf("FAIL: %s: %s", what, input);
+        ++failures;
+    }
+}
+
+void checkParsers() {
+    for (const auto& expected : STAT_CASES) {
+        ProcStat stat;
+        bool parsed = parseProcStat(expected.content, stat);
+        check(parsed, "parseProcStat rejected", expected.content);
+        if (!parsed) continue;
+        check(stat.comm == expected.comm, "comm", expected.content);
+        check(stat.state == expected.state, "state", expected.content);
+        check(stat.ppid == expected.ppid, "ppid", expected.content);
+        check(stat.utime == expected.utime && stat.stime == expected.stime, "utime/stime", expected.content);
+        check(stat.numThreads == expected.numThreads, "num_threads", expected.content);
+        check(stat.startTime == expected.startTime, "starttime", expected.content);
+    }
+    ProcStat truncated;
+    check(!parseProcStat("12 (short) S 1 2 3\n", truncated), "truncated stat accepted", "12 (short) S 1 2 3\n");
+
+    const char* statmContent = "5380 1208 1033 5 0 177 0\n";
+    ProcStatm statm;
+    check(parseProcStatm(statmContent, statm) && statm.size == 5380 && statm.resident == 1208 && statm.shared == 1033,
+          "parseProcStatm", statmContent);
+
+    const char* ioContent = "rchar: 4096\nwchar: 100\nsyscr: 7\nsyscw: 2\nread_bytes: 8192\nwrite_bytes: 12288\n"
+                            "cancelled_write_bytes: 4096\n";
+    ProcIo io;
+    check(parseProcIo(ioContent, io) && io.readChars == 4096 && io.writeChars == 100 && io.readBytes == 8192 &&
+              io.writeBytes == 12288 && io.cancelledWriteBytes == 4096,
+          "parseProcIo", ioContent);
+}
+
+std::string readWhole(const std::string& path) {
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+}
+
+int main(int argc, char** argv) {
+    checkParsers();
+    if (failures > 0) {
+        return 1;
+    }
+    std::printf("parser checks passed\n");
+
+    std::vector<std::string> stats, statms, ios;
+    DIR* proc = opendir("/proc");
+    if (!proc) {
+        return 1;
+    }
+    while (struct dirent* entry = readdir(proc)) {
+        int pid;
+        if (!parsePid(entry->d_name, pid)) continue;
+        std::string base = std::string("/proc/") + entry->d_name;
+        stats.push_back(readWhole(base + "/stat"));
+        statms.push_back(readWhole(base + "/statm"));
+        ios.push_back(readWhole(base + "/io"));
+    }
+    closedir(proc);
+
+    int rounds = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 2000;
+    size_t processes = stats.size();
+    volatile unsigned long long sink = 0;
+
+    // what ProcessMonitor did before: stream every file, token by token
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < processes; ++i) {
+            std::istringstream stat(stats[i]);
+            std::string token;
+            unsigned long long utime = 0, stime = 0;
+            for (int field = 1; field <= 13; ++field) stat >> token;
+            stat >> utime >> stime;
+            sink = sink + utime + stime;
+
+            std::istringstream statm(statms[i]);
+            unsigned long long size = 0, resident = 0;
+            statm >> size >> resident;
+            sink = sink + resident;
+
+            std::istringstream io(ios[i]);
+            std::string line;
+            while (std::getline(io, line)) {
+                std::istringstream fields(line);
+                std::string key;
+                long long value;
+                if (fields >> key >> value && (key == "read_bytes:" || key == "write_bytes:")) {
+                    sink = sink + static_cast<unsigned long long>(value);
+                }
+            }
+        }
+    }
+    auto streamed = std::chrono::steady_clock::now();
+
+    for (int round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < processes; ++i) {
+            ProcStat stat;
+            if (parseProcStat(stats[i], stat)) sink = sink + stat.utime + stat.stime;
+            ProcStatm statm;
+            if (parseProcStatm(statms[i], statm)) sink = sink + statm.resident;
+            ProcIo io;
+            if (parseProcIo(ios[i], io)) sink = sink + static_cast<unsigned long long>(io.readBytes + io.writeBytes);
+        }
+    }
+    auto parsed = std::chrono::steady_clock::now();
+
+    double samples = static_cast<double>(rounds) * static_cast<double>(processes);
+    std::printf("%zu processes x %d rounds: istringstream %.0f ns/process, proc_parsers %.0f ns/process\n", processes,
+                rounds, std::chrono::duration<double, std::nano>(streamed - start).count() / samples,
+                std::chrono::duration<double, std::nano>(parsed - streamed).count() / samples);
+    return 0;
+}
@@ -0,0 +1,51 @@
+// Reader latency of ProcessMonitorThread::getProcesses while scans run back to back.
+//
+//   snapshot_latency [seconds] [scan interval ms] [scan threads]
+//
+// Spins on getProcesses for the given time and prints the latency percentiles. Exits 1 when
+// p99 is 1 us or more: a reader must never wait for a scan.
+#include "../include/process_monitor_thread.h"
+#include "../include/memory_sampler.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char** argv) {
+    int seconds = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 3;
+    Config config;
+    config.setUpdateIntervalMs(argc > 2 ? std::max(std::atoi(argv[2]), 1) : 1);
+    config.setProcessScanThreads(argc > 3 ? std::max(std::atoi(argv[3]), 1) : 1);
+
+    SelfStats stats;
+    ProcessMonitorThread monitor(config, std::make_shared<MemorySampler>(), stats);
+    monitor.start();
+    // let the first scans publish, so readers see a full table
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    std::vector<double> latencies;
+    latencies.reserve(4000000);
+    size_t rows = 0;
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    while (std::chrono::steady_clock::now() < end) {
+        auto before = std::chrono::steady_clock::now();
+        auto processes = monitor.getProcesses(40);
+        auto after = std::chrono::steady_clock::now();
+        rows = processes->size();
+        latencies.push_back(std::chrono::duration<double, std::nano>(after - before).count());
+    }
+    monitor.stop();
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies[static_cast<size_t>(p * static_cast<double>(latencies.size() - 1))];
+    };
+    double p99 = percentile(0.99);
+    std::printf("%zu calls, %zu processes, %llu scans: p50 %.0f ns, p99 %.0f ns, p99.9 %.0f ns, max %.0f ns\n",
+                latencies.size(), rows, static_cast<unsigned long long>(stats.get("processes").latency.count()),
+                percentile(0.5), p99, percentile(0.999), latencies.back());
+    if (p99 >= 1000) {
+        std::printf("FAIL: p99 reader latency is over 1 us\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct CgroupInfo {
+    // relative to the cgroup root; "/" for the root itself
+    std::string path;
+    int depth;
+    // percent of one CPU, like the process list
+    double cpuUsage;
+    // time throttled by cpu.max, summed over CPUs like cpuUsage, as a percent of the
+    // interval; and how many enforcement periods were throttled
+    double throttledPercent;
+    unsigned long long throttledPeriods;
+    unsigned long long memoryCurrent;
+    // memory.stat anon and file bytes, io.stat totals and pids.current; only filled in for
+    // the rows the view asked for
+    unsigned long long memoryAnon;
+    unsigned long long memoryFile;
+    double ioReadBytesPerSec;
+    double ioWriteBytesPerSec;
+    unsigned long long pids;
+    bool hasCpu;
+    bool hasMemory;
+    bool hasIo;
+    bool hasPids;
+};
+
+// Follows the cgroup v2 hierarchy (/sys/fs/cgroup, or /sys/fs/cgroup/unified on hybrid
+// systems). The tree is walked once and again only when inotify reports a cgroup being
+// created, removed or renamed. Interface files are opened once and re-read with pread.
+// Every cgroup costs two reads per tick (cpu.stat, memory.current); memory.stat, io.stat
+// and pids.current are only read for the leading rows the view shows. v2 counters already
+// include descendants, so no summing over the tree is needed. Only setDetailRows may be
+// called while update runs.
+class CgroupMonitor {
+public:
+    CgroupMonitor();
+    ~CgroupMonitor();
+    CgroupMonitor(const CgroupMonitor&) = delete;
+    CgroupMonitor& operator=(const CgroupMonitor&) = delete;
+
+    void update();
+    // how many rows the next update ranks and reads details for
+    void setDetailRows(size_t visibleRows);
+    // busiest cgroups by CPU from the last update, at most the detail rows of them
+    const std::vector<CgroupInfo>& getCgroups() const;
+    size_t cgroupCount() const;
+    bool isAvailable() const;
+
+private:
+    enum CgroupFile {
+        CPU_STAT,
+        MEMORY_CURRENT,
+        MEMORY_STAT,
+        IO_STAT,
+        PIDS_CURRENT,
+        FILE_COUNT
+    };
+    static constexpr int NOT_OPENED = -1;
+    static constexpr int UNAVAILABLE = -2;
+    static constexpr unsigned RESCAN_TICKS = 30;
+    static constexpr size_t DEFAULT_DETAIL_ROWS = 32;
+
+    struct Cgroup {
+        CgroupInfo info;
+        std::array<int, FILE_COUNT> fds;
+        unsigned long long usageUsec;
+        unsigned long long throttledUsec;
+        unsigned long long nrThrottled;
+        unsigned long long ioRead;
+        unsigned long long ioWrite;
+        std::chrono::steady_clock::time_point ioTime;
+        bool cpuValid;
+        bool ioValid;
+    };
+
+    std::string root;
+    std::vector<Cgroup> cgroups;
+    std::vector<uint32_t> order;
+    std::vector<CgroupInfo> rows;
+    std::atomic<size_t> detailRows;
+    int inotifyFd;
+    bool rewalkNeeded;
+    // false when inotify watches could not all be added; the tree is then re-walked every RESCAN_TICKS
+    bool watchesComplete;
+    unsigned ticksSinceWalk;
+    std::chrono::steady_clock::time_point lastUpdate;
+    std::string buffer;
+    std::vector<char> eventBuffer;
+
+    void walk();
+    bool drainEvents();
+    std::optional<std::string_view> readFile(Cgroup& cgroup, CgroupFile file);
+    void readDetails(Cgroup& cgroup, std::chrono::steady_clock::time_point now);
+    static void closeFiles(Cgroup& cgroup);
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "self_stats.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs collectors on their own periods. Each collector has a timerfd; one dispatcher thread
+// waits on all of them with epoll and queues the ones that are due for a small pool of
+// workers. A collector never runs twice at once: if its last run is still going when its timer
+// fires, that tick is skipped rather than queued, so a slow collector holds at most one worker
+// and only ever costs its own ticks. Every run is timed into stats under the collector's name,
+// with how late it started against its timer.
+class CollectorScheduler {
+public:
+    CollectorScheduler(size_t threadCount, SelfStats& stats);
+    ~CollectorScheduler();
+    CollectorScheduler(const CollectorScheduler&) = delete;
+    CollectorScheduler& operator=(const CollectorScheduler&) = delete;
+
+    // Only before start().
+    void add(std::string name, int periodMs, std::function<void()> collect);
+    // Runs every collector once on the calling thread, in the order they were added. Only
+    // before start() or after stop().
+    void runAll();
+
+    bool start(std::string& error);
+    void stop();
+
+    // eventfd for an event loop to redraw on; -1 until start(). A worker signals when it
+    // finishes a run and finds nothing else queued, so runs that fell due together mostly
+    // signal once.
+    int readyFd() const;
+    // ticks dropped because the collector was still busy with the previous one
+    unsigned long long skippedTicks(const std::string& name) const;
+
+private:
+    struct Collector {
+        std::string name;
+        int periodMs;
+        std::function<void()> collect;
+        SelfStat* stat;
+        int timerFd;
+        // the expiry that queued the current run
+        std::chrono::steady_clock::time_point due;
+        bool busy;
+        unsigned long long skipped;
+    };
+
+    size_t threadCount;
+    SelfStats& stats;
+    std::vector<Collector> collectors;
+    int epollFd;
+    int stopFd;
+    int doneFd;
+    std::thread dispatcher;
+    std::vector<std::thread> workers;
+
+    mutable std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<size_t> queue;
+    bool stopping;
+
+    void dispatch();
+    void workerLoop();
+    void closeFds();
+};
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 class Config {
 public:
@@ -13,11 +14,54 @@ public:
     double getMemoryThreshold() const;
     double getDiskThreshold() const;
     double getGpuTempThreshold() const;
+    int getProcessScanThreads() const;
+    bool getProcessEventMode() const;
+    std::string getProcessCollector() const;
+    size_t getProcessDeltaMaxBytes() const;
+    std::vector<int> getExpandedPids() const;
+    int getDiskCapacityIntervalMs() const;
+    int getDiskStatTimeoutMs() const;
+    double getDiskIOUtilThreshold() const;
+    double getDiskIOLatencyThresholdMs() const;
+    // PSI trigger for "cpu", "memory" or "io", e.g. "some 150000 1000000"; empty when disabled
+    std::string getPressureTrigger(const std::string& resource) const;
+    bool getPacketCaptureEnabled() const;
+    // empty captures on every interface
+    std::string getPacketCaptureInterface() const;
+    int getPacketRingMb() const;
+    int getPacketSnaplen() const;
+    // period of one SystemMonitor collector ("cpu", "memory", "disk", "gpu", "network", ...)
+    int getCollectorIntervalMs(const std::string& collector) const;
+    int getCollectorThreads() const;
+    // period of the records written in headless mode
+    int getRecordIntervalMs() const;
+    // memory shared by every metric's history rings, and how far back they reach
+    int getHistoryMemoryMb() const;
+    int getHistoryRetentionSeconds() const;
     void setUpdateIntervalMs(int interval);
     void setCpuThreshold(double threshold);
     void setMemoryThreshold(double threshold);
     void setDiskThreshold(double threshold);
     void setGpuTempThreshold(double threshold);
+    void setProcessScanThreads(int threads);
+    void setProcessEventMode(bool enabled);
+    void setProcessCollector(const std::string& collector);
+    void setProcessDeltaMaxBytes(size_t bytes);
+    void setExpandedPids(const std::vector<int>& pids);
+    void setDiskCapacityIntervalMs(int interval);
+    void setDiskStatTimeoutMs(int timeout);
+    void setDiskIOUtilThreshold(double threshold);
+    void setDiskIOLatencyThresholdMs(double threshold);
+    void setPressureTrigger(const std::string& resource, const std::string& trigger);
+    void setPacketCaptureEnabled(bool enabled);
+    void setPacketCaptureInterface(const std::string& interface);
+    void setPacketRingMb(int megabytes);
+    void setPacketSnaplen(int bytes);
+    void setCollectorIntervalMs(const std::string& collector, int interval);
+    void setCollectorThreads(int threads);
+    void setRecordIntervalMs(int interval);
+    void setHistoryMemoryMb(int megabytes);
+    void setHistoryRetentionSeconds(int seconds);
 
 private:
     std::unordered_map<std::string, std::string> settings;
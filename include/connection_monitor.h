@@ -0,0 +1,71 @@
+#pragma once
+
+#include "socket_inventory.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct TcpConnection {
+    std::string local;
+    std::string remote;
+    // TCP_ESTABLISHED, TCP_LISTEN, ... from <netinet/tcp.h>
+    unsigned char state;
+    unsigned long long inode;
+    unsigned int uid;
+    // 0 when no process we can see holds the socket
+    int pid;
+    // send queue is bytes not yet acknowledged by the peer, receive queue bytes not yet read
+    // by the process; for listeners they are the backlog limit and current length
+    unsigned long long sendQueue;
+    unsigned long long receiveQueue;
+    // from tcp_info; only meaningful when hasInfo
+    double rttMs;
+    double rttVarianceMs;
+    unsigned int congestionWindow;
+    unsigned int retransmits;
+    bool hasInfo;
+};
+
+struct ProcessConnections {
+    int pid;
+    std::string name;
+    size_t connections;
+    size_t listening;
+    double averageRttMs;
+    double maxRttMs;
+    unsigned long long retransmits;
+    unsigned long long sendQueue;
+    unsigned long long receiveQueue;
+    // indices into getConnections(), slowest round trip first
+    std::vector<uint32_t> members;
+};
+
+// Dumps TCP sockets through NETLINK_SOCK_DIAG with tcp_info attached (INET_DIAG_INFO) and
+// joins them to processes through a SocketOwnerIndex.
+class ConnectionMonitor {
+public:
+    ConnectionMonitor();
+
+    bool update();
+    const std::vector<TcpConnection>& getConnections() const;
+    // per-process totals, busiest first; sockets without a known owner are grouped under pid 0
+    const std::vector<ProcessConnections>& getProcesses() const;
+    const std::string& getError() const;
+    // how many /proc/<pid>/fd links have been read, for judging the index's cost
+    unsigned long long fdLinksRead() const;
+
+    static const char* stateName(unsigned char state);
+
+private:
+    NetlinkSocket diagSocket;
+    std::vector<char> requestBuffer;
+    std::vector<char> receiveBuffer;
+    std::vector<TcpConnection> connections;
+    std::vector<ProcessConnections> processes;
+    SocketOwnerIndex ownerIndex;
+    std::vector<SocketOwnerIndex::Socket> sockets;
+    std::string error;
+
+    void handleSocket(const struct inet_diag_msg& message, const void* attributes, size_t length);
+    void summarize();
+};
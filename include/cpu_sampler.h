@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Share of elapsed CPU time per state over the last sample interval, in percent.
+struct CpuBreakdown {
+    double user;
+    double nice;
+    double system;
+    double idle;
+    double iowait;
+    double irq;
+    double softirq;
+    double steal;
+    // everything except idle and iowait
+    double utilization;
+    bool online;
+};
+
+// Reads the aggregate and per-CPU lines of /proc/stat through one descriptor that stays open,
+// in a single pass per sample. Cores are indexed by CPU number; CPUs missing from /proc/stat
+// (offline) are reported with online == false and start from a fresh baseline when they return.
+class CpuSampler {
+public:
+    CpuSampler();
+    ~CpuSampler();
+    CpuSampler(const CpuSampler&) = delete;
+    CpuSampler& operator=(const CpuSampler&) = delete;
+
+    bool sample();
+    const CpuBreakdown& aggregate() const;
+    const std::vector<CpuBreakdown>& cores() const;
+
+private:
+    // jiffies in /proc/stat column order: user nice system idle iowait irq softirq steal
+    static constexpr size_t FIELD_COUNT = 8;
+    struct CpuTimes {
+        unsigned long long fields[FIELD_COUNT];
+        bool valid;
+    };
+
+    int fd;
+    std::string buffer;
+    CpuTimes lastAggregate;
+    std::vector<CpuTimes> lastCores;
+    CpuBreakdown aggregateBreakdown;
+    std::vector<CpuBreakdown> coreBreakdowns;
+
+    static void computeBreakdown(const CpuTimes& last, const CpuTimes& current, CpuBreakdown& breakdown);
+};
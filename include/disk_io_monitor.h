@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct DiskIOStats {
+    // kernel name: sda2, nvme0n1, dm-0, ...
+    std::string name;
+    // the device-mapper name for dm devices, otherwise the kernel name
+    std::string label;
+    // whole disk a partition belongs to; empty for whole disks
+    std::string parent;
+    double readIops;
+    double writeIops;
+    double readBytesPerSec;
+    double writeBytesPerSec;
+    // average time per request completed in the interval, queueing included
+    double readLatencyMs;
+    double writeLatencyMs;
+    // average number of requests outstanding over the interval
+    double queueDepth;
+    // percent of the interval with at least one request in flight
+    double utilization;
+    unsigned long long inFlight;
+};
+
+// Samples /proc/diskstats through one descriptor that stays open and turns the counters into
+// per-device rates. The whole file is one read however many devices there are; sysfs is
+// only consulted the first time a device shows up, to find its parent disk and dm name.
+// Devices that have never done I/O, and ram/loop devices, are left out.
+class DiskIOMonitor {
+public:
+    DiskIOMonitor();
+    ~DiskIOMonitor();
+    DiskIOMonitor(const DiskIOMonitor&) = delete;
+    DiskIOMonitor& operator=(const DiskIOMonitor&) = delete;
+
+    bool update();
+    const std::vector<DiskIOStats>& getDevices() const;
+
+private:
+    struct Counters {
+        unsigned long long reads;
+        unsigned long long readSectors;
+        unsigned long long readMs;
+        unsigned long long writes;
+        unsigned long long writeSectors;
+        unsigned long long writeMs;
+        unsigned long long inFlight;
+        unsigned long long ioMs;
+        unsigned long long weightedMs;
+    };
+
+    int fd;
+    std::string buffer;
+    std::vector<DiskIOStats> devices;
+    std::vector<Counters> lastCounters;
+    std::vector<uint64_t> keys;
+    std::vector<char> seen;
+    // (major << 32 | minor) -> index into devices
+    std::unordered_map<uint64_t, size_t> slots;
+    std::chrono::steady_clock::time_point lastSample;
+    bool hasSample;
+
+    size_t addDevice(uint64_t key, std::string_view name);
+    void dropUnseen();
+};
@@ -2,13 +2,15 @@
 
 #include "system_monitor.h"
 #include "network_monitor.h"
+#include "self_stats.h"
 #include <ncurses.h>
 #include <vector>
 #include <string>
 
 class Display {
 public:
-    Display();
+    // every panel update is timed into stats as "panel <name>"
+    explicit Display(SelfStats& stats);
     ~Display();
     void update(const SystemMonitor& monitor);
     bool handleInput();
@@ -30,6 +32,31 @@ private:
 
     std::vector<std::string> logMessages;
     size_t processListScrollPosition;
+    // pid of the highlighted (top) row, which 't' expands into its threads
+    int selectedPid;
+    std::vector<int> expandedPids;
+    bool expandedPidsChanged;
+    // 'c', 'n' and 's' swap the process list for the cgroup, connection or self-stats view;
+    // each keeps its own scroll position
+    enum class ListView { Processes, Cgroups, Connections, SelfStats };
+    ListView listView;
+    size_t cgroupScrollPosition;
+    size_t connectionScrollPosition;
+    size_t selfStatsScrollPosition;
+    SelfStats& selfStats;
+    // panel timers, resolved once so a frame does not look them up by name
+    SelfStat& timePanelStat;
+    SelfStat& cpuPanelStat;
+    SelfStat& memoryPanelStat;
+    SelfStat& diskPanelStat;
+    SelfStat& processPanelStat;
+    SelfStat& cgroupPanelStat;
+    SelfStat& connectionPanelStat;
+    SelfStat& selfStatsPanelStat;
+    SelfStat& networkPanelStat;
+    SelfStat& logPanelStat;
+    SelfStat& gpuPanelStat;
+    SelfStat& batteryPanelStat;
     bool needsUpdate;
     int networkWindowWidth;
 
@@ -38,15 +65,26 @@ private:
     void updateCPUWindow(const SystemMonitor& monitor);
     void updateMemoryWindow(const SystemMonitor& monitor);
     void updateDiskWindow(const SystemMonitor& monitor);
-    void updateProcessWindow(const std::vector<ProcessInfo>& processes);
+    void updateProcessWindow(const ProcessSnapshot& processes);
+    void updateCgroupWindow(const SystemMonitor& monitor);
+    void updateConnectionWindow(const SystemMonitor& monitor);
+    void updateSelfStatsWindow();
+    void updateListWindow(const SystemMonitor& monitor);
     void updateNetworkInfo(const std::vector<NetworkInterface>& interfaces);
     void updateLogWindow();
     void updateGPUInfo(const std::vector<GPUInfo>& gpuInfos);
     void updateBatteryInfo(const SystemMonitor& monitor);
     void updateTimeInfo(const SystemMonitor& monitor);
     void scrollProcessList(int direction);
+    void toggleThreadView();
+    void toggleListView(ListView view);
+    void publishExpandedPids(const SystemMonitor& monitor);
+    size_t visibleProcessRows() const;
+    size_t visibleCgroupRows() const;
 
     std::string formatUptime(long uptime) const;
+    std::string formatPressure(const ResourcePressure& pressure) const;
+    std::string formatTrend(const MetricHistory& history, const std::string& series) const;
     std::string getCurrentTime() const;
     void drawBarGraph(WINDOW* win, int y, int x, int width, double percentage);
     std::string formatBytes(unsigned long long bytes);
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Values from /proc/meminfo in kB, except the HugePages_* counts which are in pages.
+struct MemoryInfo {
+    unsigned long long memTotal;
+    unsigned long long memFree;
+    unsigned long long memAvailable;
+    unsigned long long buffers;
+    unsigned long long cached;
+    unsigned long long swapCached;
+    unsigned long long swapTotal;
+    unsigned long long swapFree;
+    unsigned long long dirty;
+    unsigned long long writeback;
+    unsigned long long shmem;
+    unsigned long long slab;
+    unsigned long long sReclaimable;
+    unsigned long long sUnreclaim;
+    unsigned long long anonHugePages;
+    unsigned long long hugePagesTotal;
+    unsigned long long hugePagesFree;
+    unsigned long long hugePageSize;
+    // MemAvailable arrived in 3.14; without it available memory is estimated from free + buffers + cached
+    bool hasMemAvailable;
+
+    unsigned long long available() const;
+    double usedPercent() const;
+};
+
+// Parses /proc/meminfo through one descriptor that stays open. Keys are matched against a
+// fixed table and the line each one was found on is remembered, so after the first sample a
+// line costs one comparison. The sampling thread owns sample() and info(); totalKb() may be
+// read from any thread.
+class MemorySampler {
+public:
+    MemorySampler();
+    ~MemorySampler();
+    MemorySampler(const MemorySampler&) = delete;
+    MemorySampler& operator=(const MemorySampler&) = delete;
+
+    bool sample();
+    const MemoryInfo& info() const;
+    unsigned long long totalKb() const;
+
+private:
+    int fd;
+    std::string buffer;
+    MemoryInfo current;
+    // table slot found on each line of the last sample, or -1 for keys not tracked
+    std::vector<int8_t> lineSlots;
+    std::atomic<unsigned long long> total;
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Summary of one series over a time window. On a rollup tier min and max are exact, while avg
+// and p95 are taken over the bucket averages.
+struct WindowStats {
+    size_t samples = 0;
+    float min = 0;
+    float max = 0;
+    float avg = 0;
+    float p95 = 0;
+    // resolution the answer came from, 0 for raw samples
+    int64_t resolutionMs = 0;
+};
+
+// Fixed-capacity history for every metric SystemMonitor publishes. Each series keeps a raw
+// ring sized for the retention at its sampling interval (at most 4096 samples), plus 10 s and
+// 1 min rollup rings for series sampled faster than those. Rings are column-wise (timestamps,
+// then float values) and allocated once, when the series is first seen, against a byte budget
+// shared by all series: a series that no longer fits gets a shorter raw ring, or is not
+// recorded at all. Retired series (a link or disk that went away) hand their rings to the
+// next series of the same shape, or give their bytes back when nothing of that shape comes.
+//
+// append is O(1). Queries binary-search the window's start and scan one contiguous column, on
+// the finest tier that still covers the window. Not synchronized; SystemMonitor appends under
+// its state lock and reads under the shared lock like every other published field.
+class MetricHistory {
+public:
+    using SeriesId = uint32_t;
+    static constexpr SeriesId NO_SERIES = std::numeric_limits<SeriesId>::max();
+
+    MetricHistory(size_t budgetBytes, int retentionSeconds);
+
+    // Finds or creates the series; NO_SERIES once the budget is spent. intervalMs is how often
+    // it will be appended to, which sizes the raw ring.
+    SeriesId series(const std::string& name, int intervalMs);
+    // NO_SERIES when the series has never been created
+    SeriesId find(const std::string& name) const;
+    // timestamps are steady-clock milliseconds and must not go backwards; NO_SERIES is ignored
+    void append(SeriesId id, int64_t timestampMs, float value);
+    // Drops the series and its samples. The id may be handed out again by series().
+    void retire(SeriesId id);
+
+    // samples with fromMs <= timestamp <= toMs; false when there are none
+    bool query(SeriesId id, int64_t fromMs, int64_t toMs, WindowStats& stats) const;
+    // the last spanMs up to the series' newest sample
+    bool recent(SeriesId id, int64_t spanMs, WindowStats& stats) const;
+
+    size_t bytesUsed() const;
+    size_t budget() const;
+
+private:
+    struct Tier {
+        int64_t resolutionMs;
+        size_t capacity;
+        // next slot to write and number of slots filled
+        size_t head;
+        size_t size;
+        std::vector<int64_t> timestamps;
+        // the sample on the raw tier, the bucket average on rollups
+        std::vector<float> values;
+        // rollups only
+        std::vector<float> minimums;
+        std::vector<float> maximums;
+        // bucket being filled, pushed to the ring when a sample lands in a later bucket
+        int64_t bucketStart;
+        size_t bucketCount;
+        float bucketMin;
+        float bucketMax;
+        double bucketSum;
+    };
+
+    struct Series {
+        std::string name;
+        // empty once a retired series has given its bytes back
+        std::vector<Tier> tiers;
+        bool live;
+    };
+
+    size_t budgetBytes;
+    int64_t retentionMs;
+    size_t used;
+    std::vector<Series> allSeries;
+    std::unordered_map<std::string, SeriesId> byName;
+    // retired ids, oldest first
+    std::vector<SeriesId> retired;
+
+    bool isLive(SeriesId id) const;
+    // frees the oldest retired rings; false when none are left
+    bool releaseRetired();
+    static size_t tierBytes(size_t capacity, bool rollup);
+    static size_t seriesBytes(const Series& series);
+    static void push(Tier& tier, int64_t timestampMs, float value, float minimum, float maximum);
+    static void flushBucket(Tier& tier);
+    // physical slot of the logical index, 0 being the oldest sample
+    static size_t slot(const Tier& tier, size_t index);
+    // logical index of the first sample at or after timestampMs
+    static size_t lowerBound(const Tier& tier, int64_t timestampMs);
+    static int64_t oldest(const Tier& tier);
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+class SystemMonitor;
+
+enum class RecordFormat {
+    // InfluxDB line protocol: one line per measurement, all sharing the record's timestamp
+    Line,
+    // one JSON object per line
+    Json
+};
+
+// Serializes the monitor's published state, one record per call, for headless runs. The
+// record is formatted with std::to_chars into a buffer that only grows when a record
+// outgrows every earlier one, and leaves in a single write(2), so a steady stream allocates
+// nothing.
+class MetricWriter {
+public:
+    // fd stays owned by the caller
+    MetricWriter(RecordFormat format, int fd);
+
+    // Reads the monitor's getters, so call it where they may be read: from SystemMonitor::run.
+    // false once the output has failed (a closed pipe, a full disk); getError says why.
+    bool write(const SystemMonitor& monitor, unsigned long long timestampNs);
+    const std::string& getError() const;
+
+    // "line" or "json"
+    static bool parseFormat(const std::string& name, RecordFormat& format);
+
+private:
+    RecordFormat format;
+    int fd;
+    std::vector<char> buffer;
+    size_t used;
+    unsigned long long timestamp;
+    std::string error;
+    // where the record being written is: the line-protocol measurement, and whether the
+    // current group, entry and its fields have started
+    std::string_view measurement;
+    bool listGroup;
+    bool firstEntry;
+    bool firstField;
+
+    // The record is described once, as groups of entries with tags and fields, and each format
+    // renders that: a group is a measurement in line protocol and a key of the JSON object, with
+    // an array for groups of several entries.
+    void writeRecord(const SystemMonitor& monitor);
+    void beginGroup(std::string_view name, bool list);
+    void endGroup();
+    void beginEntry();
+    void endEntry();
+    void tag(std::string_view key, std::string_view value);
+    void tag(std::string_view key, unsigned long long value);
+    void field(std::string_view key, double value);
+    void integerField(std::string_view key, unsigned long long value);
+    void booleanField(std::string_view key, bool value);
+    // separator and key of the next field
+    void fieldKey(std::string_view key);
+
+    char* reserve(size_t length);
+    void append(std::string_view text);
+    void appendInteger(unsigned long long value);
+    void appendDecimal(double value);
+    // line protocol tag value: commas, spaces and equals signs are backslash-escaped
+    void appendTag(std::string_view value);
+    void appendJsonString(std::string_view value);
+};
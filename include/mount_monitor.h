@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct DiskPartitionInfo {
+    std::string name;
+    std::string mountPoint;
+    unsigned long long totalSpace;
+    unsigned long long usedSpace;
+    // the last statvfs did not answer within the timeout; sizes are from the last one that did
+    bool stale;
+};
+
+// Caches the mount table and only re-reads it when poll() on /proc/self/mounts reports
+// POLLPRI. Capacities come from a background thread on their own cadence, and each statvfs
+// runs with a timeout, so a hung NFS or FUSE mount neither blocks the caller's tick nor
+// holds up the other mounts. A mount whose call is still stuck is skipped until it returns.
+class MountMonitor {
+public:
+    MountMonitor(int capacityIntervalMs, int statTimeoutMs);
+    ~MountMonitor();
+    MountMonitor(const MountMonitor&) = delete;
+    MountMonitor& operator=(const MountMonitor&) = delete;
+
+    void start();
+    void stop();
+
+    // Never blocks. Re-reads the mount table if the kernel flagged a change since the last call.
+    void update();
+    // Copies the listed partitions into out if capacities or the mount table changed since the
+    // last copy; returns whether it did.
+    bool refreshPartitions(std::vector<DiskPartitionInfo>& out);
+    // "/" is tracked whatever its device, for the overall disk usage figure
+    std::optional<DiskPartitionInfo> root() const;
+
+private:
+    struct Probe;
+    struct Mount {
+        DiskPartitionInfo info;
+        bool listed;
+        bool sampled;
+        // set while a statvfs that overran its timeout is still outstanding
+        std::shared_ptr<Probe> pending;
+    };
+
+    int mountsFd;
+    std::string buffer;
+    std::chrono::milliseconds capacityInterval;
+    std::chrono::milliseconds statTimeout;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<Mount> mounts;
+    uint64_t generation;
+    uint64_t copiedGeneration;
+    bool mountsChanged;
+    std::atomic<bool> running;
+    std::thread capacityThread;
+
+    void readMountTable();
+    void sampleCapacities();
+    void runCapacityThread();
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <linux/netlink.h>
+
+// Builds one or more netlink messages back to back in a caller-owned buffer, so a batch of
+// requests can go out in a single send().
+class NetlinkMessageWriter {
+public:
+    explicit NetlinkMessageWriter(std::vector<char>& buffer);
+
+    void begin(uint16_t type, uint16_t flags, uint32_t sequence);
+    void appendHeader(const void* header, size_t length);
+    void addAttribute(uint16_t type, const void* data, size_t length);
+    void end();
+
+private:
+    std::vector<char>& buffer;
+    size_t messageStart;
+
+    void appendAligned(const void* data, size_t length);
+};
+
+class NetlinkSocket {
+public:
+    NetlinkSocket();
+    ~NetlinkSocket();
+    NetlinkSocket(const NetlinkSocket&) = delete;
+    NetlinkSocket& operator=(const NetlinkSocket&) = delete;
+
+    bool open(int protocol, uint32_t groups, std::string& error);
+    void close();
+    bool isOpen() const;
+    int fd() const;
+    uint32_t nextSequence();
+
+    bool send(const std::vector<char>& messages);
+    // Receives one datagram. Returns its length, 0 if nothing is queued (when not blocking),
+    // or -1 with errno set.
+    ssize_t receive(std::vector<char>& buffer, bool block);
+
+private:
+    int sock;
+    uint32_t sequence;
+};
+
+// Calls fn(type, payload, payloadLength) for each attribute in [data, data + length).
+template<typename Fn>
+void forEachNetlinkAttribute(const void* data, size_t length, Fn fn) {
+    auto* attribute = static_cast<const struct nlattr*>(data);
+    while (length >= NLA_HDRLEN && attribute->nla_len >= NLA_HDRLEN && attribute->nla_len <= length) {
+        fn(static_cast<uint16_t>(attribute->nla_type & NLA_TYPE_MASK),
+           reinterpret_cast<const char*>(attribute) + NLA_HDRLEN,
+           static_cast<size_t>(attribute->nla_len - NLA_HDRLEN));
+        size_t advance = NLA_ALIGN(attribute->nla_len);
+        if (advance >= length) break;
+        length -= advance;
+        attribute = reinterpret_cast<const struct nlattr*>(reinterpret_cast<const char*>(attribute) + advance);
+    }
+}
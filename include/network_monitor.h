@@ -1,13 +1,18 @@
 #pragma once
 
+#include "netlink_socket.h"
 #include <string>
 #include <vector>
 #include <chrono>
 #include <unordered_map>
 
 struct NetworkInterface {
+    // kernel ifindex
+    int index;
     std::string name;
+    // ethernet, wireless, loopback, or the rtnetlink kind of virtual links: bond, vlan, veth, bridge, ...
     std::string type;
+    // first IPv4 address, else the first global IPv6 one
     std::string ipAddress;
     unsigned long long bytesReceived;
     unsigned long long bytesSent;
@@ -17,20 +22,59 @@ struct NetworkInterface {
     double maxUploadSpeed;
     unsigned long long totalBytesReceived;
     unsigned long long totalBytesSent;
+    double packetsReceivedPerSec;
+    double packetsSentPerSec;
+    unsigned long long receiveErrors;
+    unsigned long long sendErrors;
+    unsigned long long receiveDropped;
+    unsigned long long sendDropped;
 };
 
+// Samples every link with one RTM_GETLINK dump per tick, reading the kernel's 64-bit counters
+// (IFLA_STATS64) instead of a handful of sysfs files per interface. Addresses are dumped once
+// and then kept current from RTM_NEWADDR/RTM_DELADDR notifications.
 class NetworkMonitor {
 public:
     NetworkMonitor();
     void update();
     std::vector<NetworkInterface> getActiveInterfaces() const;
+    // whether the last update still saw the link, active or not, under that name
+    bool hasLink(int index, const std::string& name) const;
+    // why rtnetlink could not be used, empty when it is working
+    const std::string& getError() const;
 
 private:
-    std::unordered_map<std::string, NetworkInterface> interfaces;
+    struct Address {
+        unsigned char family;
+        unsigned char scope;
+        std::string text;
+    };
+
+    struct Link {
+        NetworkInterface info;
+        unsigned long long packetsReceived;
+        unsigned long long packetsSent;
+        bool active;
+        bool seen;
+    };
+
+    NetlinkSocket dumpSocket;
+    NetlinkSocket addressSocket;
+    std::vector<char> requestBuffer;
+    std::vector<char> receiveBuffer;
+    // keyed by ifindex, which unlike the name is never reused while the link exists
+    std::unordered_map<int, Link> links;
+    std::unordered_map<int, std::vector<Address>> addresses;
+    std::vector<NetworkInterface> activeInterfaces;
     std::chrono::steady_clock::time_point lastUpdateTime;
+    std::string error;
+    bool addressesStale;
 
-    std::string getInterfaceType(const std::string& name) const;
-    bool isInterfaceActive(const std::string& name) const;
-    unsigned long long readSysfsValue(const std::string& interface, const std::string& file) const;
-    std::string getIpAddress(const std::string& interface) const;
-};
\ No newline at end of file
+    bool dump(uint16_t type, unsigned char family, double elapsedSeconds);
+    void handleMessage(const struct nlmsghdr* header, double elapsedSeconds);
+    void handleLink(const struct nlmsghdr* header, double elapsedSeconds);
+    void handleAddress(const struct nlmsghdr* header);
+    void drainAddressEvents();
+    std::string getInterfaceType(const std::string& name, unsigned short arpType, const std::string& kind) const;
+    std::string primaryAddress(int index) const;
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "config.h"
+#include "socket_inventory.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct ProcessNetworkRate {
+    double receiveBytesPerSec;
+    double sendBytesPerSec;
+};
+
+using ProcessNetworkRates = std::unordered_map<int, ProcessNetworkRate>;
+
+struct PacketCaptureStats {
+    // since start
+    unsigned long long packets;
+    unsigned long long drops;
+    // over the last update interval
+    size_t flows;
+    double unattributedBytesPerSec;
+};
+
+// Attributes traffic to processes from packet headers. A capture thread walks a TPACKET_V3
+// PACKET_RX_RING shared with the kernel and adds each packet's wire length to its flow
+// (protocol, local and remote address and port); a one-instruction BPF filter caps what the
+// kernel copies into the ring at snaplen bytes, so payloads are never copied. update() maps
+// flows to socket inodes with a sock_diag dump of TCP and UDP sockets, and inodes to pids
+// through a SocketOwnerIndex, then publishes per-process rates for the process monitor.
+// Capturing needs CAP_NET_RAW.
+class PacketFlowMonitor {
+public:
+    explicit PacketFlowMonitor(const Config& config);
+    ~PacketFlowMonitor();
+    PacketFlowMonitor(const PacketFlowMonitor&) = delete;
+    PacketFlowMonitor& operator=(const PacketFlowMonitor&) = delete;
+
+    bool start(std::string& error);
+    void stop();
+
+    void update();
+    // Safe to call from any thread.
+    std::shared_ptr<const ProcessNetworkRates> getRates() const;
+    PacketCaptureStats getStats() const;
+
+private:
+    struct FlowKey {
+        uint8_t family;
+        uint8_t protocol;
+        uint16_t localPort;
+        uint16_t remotePort;
+        uint8_t local[16];
+        uint8_t remote[16];
+
+        bool operator==(const FlowKey& other) const;
+    };
+
+    struct FlowKeyHash {
+        size_t operator()(const FlowKey& key) const;
+    };
+
+    struct FlowBytes {
+        unsigned long long received;
+        unsigned long long sent;
+    };
+
+    using FlowTable = std::unordered_map<FlowKey, FlowBytes, FlowKeyHash>;
+
+    std::string interface;
+    size_t blockSize;
+    unsigned int blockCount;
+    unsigned int snaplen;
+    int fd;
+    uint8_t* ring;
+    std::thread captureThread;
+    std::atomic<bool> running;
+    std::atomic<unsigned long long> packets;
+
+    // filled by the capture thread, swapped out by update()
+    std::mutex flowMutex;
+    FlowTable flows;
+    FlowTable drained;
+
+    NetlinkSocket diagSocket;
+    std::vector<char> requestBuffer;
+    std::vector<char> receiveBuffer;
+    std::vector<SocketOwnerIndex::Socket> sockets;
+    std::unordered_map<FlowKey, unsigned long long, FlowKeyHash> socketsByFlow;
+    SocketOwnerIndex ownerIndex;
+    std::shared_ptr<const ProcessNetworkRates> rates;
+    std::chrono::steady_clock::time_point lastUpdate;
+    // last sock_diag failure; flows stay unattributed until a dump succeeds again
+    std::string diagError;
+
+    mutable std::mutex statsMutex;
+    PacketCaptureStats stats;
+
+    void runCapture();
+    void readBlock(const uint8_t* block);
+    void indexSockets(uint8_t protocol);
+    unsigned long long findSocket(FlowKey key) const;
+    void closeRing();
+};
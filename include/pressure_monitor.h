@@ -0,0 +1,71 @@
+#pragma once
+
+#include "config.h"
+#include <string>
+#include <vector>
+
+enum class PressureResource {
+    Cpu,
+    Memory,
+    Io
+};
+
+// Share of wall time, in percent, that runnable tasks were stalled on a resource.
+struct PressureStats {
+    double avg10;
+    double avg60;
+    double avg300;
+    // cumulative stall time in microseconds
+    unsigned long long total;
+};
+
+struct ResourcePressure {
+    // at least one task stalled
+    PressureStats some;
+    // all non-idle tasks stalled at once; the kernel has no "full" line for system-wide cpu before 5.13
+    PressureStats full;
+    bool hasFull;
+    bool available;
+};
+
+// Reads /proc/pressure/{cpu,memory,io} through descriptors that stay open, and registers the
+// configured kernel PSI triggers ("some 150000 1000000": 150ms of stall in any 1s window) on
+// descriptors of their own. The caller's event loop waits on the triggers alongside its other
+// descriptors, so a stall is noticed as soon as the kernel reports it rather than on the
+// next tick. Without PSI (CONFIG_PSI=n, psi=0) or without permission to create triggers,
+// the affected parts report unavailable and everything else carries on.
+class PressureMonitor {
+public:
+    explicit PressureMonitor(const Config& config);
+    ~PressureMonitor();
+    PressureMonitor(const PressureMonitor&) = delete;
+    PressureMonitor& operator=(const PressureMonitor&) = delete;
+
+    void update();
+    const ResourcePressure& get(PressureResource resource) const;
+    bool isAvailable() const;
+
+    // Reports POLLPRI/EPOLLPRI when the resource's trigger fires; -1 without a trigger. Each
+    // poll of it consumes the event, so the loop must act on the readiness it is handed
+    // rather than poll again to confirm.
+    int getTriggerFd(PressureResource resource) const;
+    // the loop saw POLLERR on the trigger, which the kernel has torn down
+    void dropTrigger(PressureResource resource);
+    const std::string& getTrigger(PressureResource resource) const;
+    // why trigger registration failed, empty when every configured trigger was registered
+    const std::string& getTriggerError() const;
+
+    static const char* resourceName(PressureResource resource);
+
+private:
+    static constexpr size_t RESOURCE_COUNT = 3;
+
+    int readFds[RESOURCE_COUNT];
+    int triggerFds[RESOURCE_COUNT];
+    std::string triggers[RESOURCE_COUNT];
+    ResourcePressure pressure[RESOURCE_COUNT];
+    std::string buffer;
+    std::string triggerError;
+
+    void registerTrigger(size_t index, const std::string& path);
+};
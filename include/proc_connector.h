@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct ProcEvent {
+    enum class Type {
+        Fork,
+        Exec,
+        Comm,
+        Exit
+    };
+    Type type;
+    int pid;
+    int tgid;
+    std::string comm;
+};
+
+// Subscription to the kernel proc connector (NETLINK_CONNECTOR / CN_IDX_PROC). Needs
+// CAP_NET_ADMIN; open() fails cleanly without it so callers can fall back to scanning /proc.
+class ProcConnector {
+public:
+    ProcConnector();
+    ~ProcConnector();
+    ProcConnector(const ProcConnector&) = delete;
+    ProcConnector& operator=(const ProcConnector&) = delete;
+
+    bool open(std::string& error);
+    bool isOpen() const;
+    int fd() const;
+
+    // Appends every queued event without blocking. Returns false if the kernel dropped events
+    // since the last call, in which case the caller's view of the process set is stale.
+    bool drain(std::vector<ProcEvent>& events);
+
+private:
+    int sock;
+
+    bool sendListen(bool listen);
+    int waitForAck();
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+enum class ProcFile {
+    Statm,
+    Io,
+    Stat,
+    Count
+};
+
+// Keeps /proc/<pid>/* descriptors open across scans so each tick costs one pread per file
+// instead of an open/read/close triple. Entries not touched during a scan are closed by endScan().
+class ProcFileCache {
+public:
+    explicit ProcFileCache(size_t maxOpenFiles);
+    ~ProcFileCache();
+    ProcFileCache(const ProcFileCache&) = delete;
+    ProcFileCache& operator=(const ProcFileCache&) = delete;
+
+    void beginScan();
+    std::optional<std::string_view> read(int pid, ProcFile file);
+    void endScan();
+    void forget(int pid);
+    size_t size() const;
+    size_t openFiles() const;
+
+private:
+    static constexpr int NOT_OPENED = -1;
+    static constexpr int UNAVAILABLE = -2;
+
+    struct Entry {
+        std::array<int, static_cast<size_t>(ProcFile::Count)> fds;
+        unsigned generation;
+    };
+
+    std::unordered_map<int, Entry> entries;
+    std::string buffer;
+    unsigned generation;
+    size_t maxOpenFiles;
+    size_t openFileCount;
+
+    int openFile(int pid, ProcFile file);
+    std::optional<std::string_view> readOnce(int pid, ProcFile file);
+    void closeEntry(Entry& entry);
+    static std::string pathFor(int pid, ProcFile file);
+};
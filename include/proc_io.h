@@ -0,0 +1,16 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+
+int openProcFile(const std::string& path);
+void closeProcFile(int fd);
+
+// Reads the whole file from offset 0 into buffer, growing it as needed. The returned view
+// points into buffer and stays valid until the buffer is next modified.
+std::optional<std::string_view> readProcFile(int fd, std::string& buffer);
+
+// Raises the soft RLIMIT_NOFILE to the hard limit and returns the resulting soft limit.
+size_t raiseOpenFileLimit();
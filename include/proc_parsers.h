@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string_view>
+
+struct ProcStat {
+    std::string_view comm;
+    char state;
+    int ppid;
+    unsigned long long utime;
+    unsigned long long stime;
+    long numThreads;
+    unsigned long long startTime;
+};
+
+struct ProcStatm {
+    unsigned long long size;
+    unsigned long long resident;
+    unsigned long long shared;
+};
+
+struct ProcIo {
+    long long readChars;
+    long long writeChars;
+    long long readBytes;
+    long long writeBytes;
+    long long cancelledWriteBytes;
+};
+
+// Allocation-free parsers over the raw contents of /proc files. Views in the results point
+// into the input and share its lifetime.
+bool parseProcStat(std::string_view content, ProcStat& stat);
+bool parseProcStatm(std::string_view content, ProcStatm& statm);
+bool parseProcIo(std::string_view content, ProcIo& io);
+
+// Token helpers shared by the /proc and /sys samplers. Each consumes from the front of input.
+std::string_view nextToken(std::string_view& input);
+std::string_view nextLine(std::string_view& input);
+bool parseUnsigned(std::string_view& input, unsigned long long& value);
+bool parseSigned(std::string_view& input, long long& value);
+bool parsePid(std::string_view text, int& pid);
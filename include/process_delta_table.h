@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+struct ProcessCounters {
+    unsigned long long cpuTimeUs;
+    unsigned long long cpuDelayNs;
+    unsigned long long blkioDelayNs;
+    unsigned long long swapinDelayNs;
+    std::chrono::steady_clock::time_point time;
+};
+
+struct ProcessDelta {
+    ProcessCounters counters;
+    // display name and a hash of the comm it was built from, so names are only rebuilt when comm
+    // changes; workqueue kthreads report comms longer than TASK_COMM_LEN, so the text isn't kept
+    uint32_t nameId;
+    size_t commHash;
+};
+
+// Open-addressing (linear probing) table holding the previous sample of each process. Keys are
+// (pid, start time), so a recycled PID gets a fresh entry instead of inheriting a stale one.
+// Entries not touched since beginGeneration() are dropped by evictStale(), and the slot array
+// never grows past maxMemoryBytes; inserts beyond that are refused and counted.
+class ProcessDeltaTable {
+public:
+    struct Stats {
+        size_t size;
+        size_t capacity;
+        size_t memoryBytes;
+        size_t maxMemoryBytes;
+        unsigned long long evictions;
+        unsigned long long rejectedInserts;
+    };
+
+    explicit ProcessDeltaTable(size_t maxMemoryBytes);
+
+    void beginGeneration();
+    // Returns the entry for the key, inserting an empty one if needed (inserted is set), or
+    // nullptr if the table is at its memory cap. The entry is marked as seen this generation.
+    ProcessDelta* findOrInsert(int pid, unsigned long long startTime, bool& inserted);
+    // Lookup without marking; seenThisGeneration reports whether the entry was touched already.
+    ProcessDelta* find(int pid, unsigned long long startTime, bool& seenThisGeneration);
+    void erase(int pid, unsigned long long startTime);
+    void evictStale();
+    Stats stats() const;
+
+private:
+    struct Slot {
+        int pid;
+        uint32_t generation;
+        unsigned long long startTime;
+        ProcessDelta value;
+    };
+
+    static constexpr size_t INITIAL_CAPACITY = 1024;
+    static constexpr double MAX_LOAD = 0.7;
+
+    std::vector<Slot> slots;
+    size_t count;
+    size_t mask;
+    size_t maxMemoryBytes;
+    uint32_t generation;
+    unsigned long long evictions;
+    unsigned long long rejectedInserts;
+
+    size_t indexFor(int pid, unsigned long long startTime) const;
+    size_t findSlot(int pid, unsigned long long startTime) const;
+    bool grow();
+    void removeAt(size_t index);
+};
@@ -3,35 +3,179 @@
 #include <vector>
 #include <string>
 #include <chrono>
-#include <map>
+#include <atomic>
+#include <memory>
+#include <unordered_set>
+#include "config.h"
+#include "memory_sampler.h"
+#include "packet_flow_monitor.h"
+#include "proc_connector.h"
+#include "proc_file_cache.h"
+#include "process_delta_table.h"
+#include "string_pool.h"
+#include "taskstats_client.h"
+#include "thread_sampler.h"
+#include "worker_pool.h"
 
 struct ProcessInfo {
     int pid;
-    std::string name;
+    uint32_t nameId;
     double cpuUsage;
     double memoryUsage;
     long long diskRead;
     long long diskWrite;
     double overallUsage;
+    // delay accounting, in milliseconds of delay per second of wall time
+    double cpuDelay;
+    double blkioDelay;
+    double swapinDelay;
+    // bytes per second, attributed from packet capture when that is enabled
+    double networkReceive;
+    double networkSend;
+    bool exited;
+};
+
+// Process list stored column by column; row i of every column describes the same process.
+struct ProcessTable {
+    std::vector<int> pid;
+    std::vector<uint32_t> nameId;
+    std::vector<float> cpuUsage;
+    std::vector<float> memoryUsage;
+    std::vector<long long> diskRead;
+    std::vector<long long> diskWrite;
+    std::vector<float> overallUsage;
+    std::vector<float> cpuDelay;
+    std::vector<float> blkioDelay;
+    std::vector<float> swapinDelay;
+    std::vector<float> networkReceive;
+    std::vector<float> networkSend;
+    std::vector<uint8_t> exited;
+    // the delay columns are only filled by the taskstats collector and stay empty otherwise
+    bool hasDelays;
+    // likewise the network columns, by packet capture
+    bool hasNetwork;
+
+    size_t size() const { return pid.size(); }
+    void resize(size_t rows);
+    void setRow(size_t row, const ProcessInfo& info);
+    ProcessInfo row(size_t row) const;
+    // Moves count rows from one position to a lower one; the ranges may overlap.
+    void moveRows(size_t from, size_t to, size_t count);
+    size_t memoryBytes() const;
+};
+
+// The result of one scan. Published snapshots are never modified, so readers can hold one
+// without locking while the next scan is built.
+struct ProcessSnapshot {
+    ProcessTable table;
+    // row indices; the leading sortedCount are in overallUsage order, the rest are unordered
+    std::vector<uint32_t> order;
+    size_t sortedCount;
+    std::shared_ptr<const StringPool> names;
+    ProcessDeltaTable::Stats deltaStats;
+    // per-thread rows, only for expanded processes
+    std::vector<ThreadInfo> threads;
+    std::vector<ThreadGroup> threadGroups;
+
+    size_t size() const { return order.size(); }
+    ProcessInfo ranked(size_t rank) const { return table.row(order[rank]); }
+    std::string_view name(const ProcessInfo& info) const { return names->get(info.nameId); }
+    const ThreadGroup* threadsOf(int pid) const;
 };
 
 class ProcessMonitor {
 public:
-    ProcessMonitor();
+    // memory is sampled by its owner; without one, a private sampler supplies MemTotal.
+    // network, when given, supplies per-process traffic rates.
+    explicit ProcessMonitor(const Config& config, std::shared_ptr<const MemorySampler> memory = nullptr,
+                            std::shared_ptr<const PacketFlowMonitor> network = nullptr);
     ~ProcessMonitor();
     void update();
-    std::vector<ProcessInfo> getProcesses() const;
+
+    // Safe to call from any thread. Only the leading rows the view can reach are kept in order; if
+    // visibleRows reaches past them, the snapshot is extended incrementally instead of fully sorted.
+    std::shared_ptr<const ProcessSnapshot> getProcesses(size_t visibleRows);
+    std::shared_ptr<const ProcessSnapshot> getSnapshot() const;
+    // Processes whose threads are listed, on top of the expanded_pids setting. Safe to call from any thread.
+    void setExpandedPids(std::vector<int> pids);
+
+    // Descriptor to wait on for proc connector events, or -1 when running on plain /proc scans.
+    int eventFd() const;
+    // Publishes exec/comm renames of listed processes, at most every RENAME_PUBLISH_INTERVAL;
+    // renames held back meanwhile are picked up by a later call or the next scan.
+    void applyProcEvents();
 
 private:
-    std::vector<ProcessInfo> processes;
+    // PIDs are assigned to shards by pid % shard count, so a PID always lands on the same shard
+    // and its descriptors and CPU deltas are only ever touched by one worker at a time.
+    struct ScanShard {
+        ScanShard(size_t maxOpenFiles, size_t maxDeltaBytes) : fileCache(maxOpenFiles), deltas(maxDeltaBytes) {}
+        ProcFileCache fileCache;
+        std::unique_ptr<TaskstatsClient> taskstats;
+        ProcessDeltaTable deltas;
+        std::vector<int> pids;
+        std::vector<int> vanished;
+        std::vector<TaskstatsSample> samples;
+        std::vector<char> sampleValid;
+        std::vector<TaskstatsSample> exited;
+        // this shard writes rows [rowBase, rowBase + rowCount) of the table being built
+        size_t rowBase;
+        size_t rowCount;
+    };
+
+    std::shared_ptr<StringPool> namePool;
+    std::shared_ptr<const ProcessSnapshot> snapshot;
+    // the worker's own references to the last two snapshots it published; once no reader holds
+    // the older one its columns are refilled instead of allocating a new table
+    std::shared_ptr<ProcessSnapshot> lastPublished;
+    std::shared_ptr<ProcessSnapshot> spareSnapshot;
+    std::atomic<size_t> sortLimit;
     std::chrono::steady_clock::time_point lastUpdateTime;
-    ProcessInfo readProcessInfoFromProc(int pid);
-    double calculateCPUUsage(int pid);
-    double getTotalSystemMemory();
-    std::map<int, std::pair<unsigned long long, std::chrono::steady_clock::time_point>> lastCPUTimes;
+    std::vector<std::unique_ptr<ScanShard>> shards;
+    WorkerPool workerPool;
+    std::unique_ptr<ProcConnector> procConnector;
+    std::unordered_set<int> trackedPids;
+    std::vector<ProcEvent> pendingEvents;
+    // renames seen since the last publish or scan, by pid; interned only once they land on a
+    // listed row, so exec churn of processes no scan lists does not fill the name pool
+    std::unordered_map<int, std::string> pendingRenames;
+    // (row, nameId) of the published table that pendingRenames touch
+    std::vector<std::pair<size_t, uint32_t>> renamedRows;
+    std::chrono::steady_clock::time_point lastRenamePublish;
+    std::string commPath;
+    std::string commBuffer;
+    bool rescanNeeded;
+    std::unique_ptr<TaskstatsClient> taskstatsExits;
+    std::vector<TaskstatsSample> exitedSamples;
+    std::chrono::steady_clock::time_point scanTime;
+    void openTaskstats();
+    void drainProcEvents();
+    void scanProcDirectory();
+    void scanShard(ScanShard& shard, ProcessTable& table);
+    void addExitedProcesses(ScanShard& shard, ProcessTable& table);
+    std::shared_ptr<ProcessSnapshot> takeSnapshotBuffer();
+    void publish(std::shared_ptr<ProcessSnapshot> next);
+    static void orderProcesses(ProcessSnapshot& snapshot, size_t count);
+    ProcessDeltaTable::Stats getDeltaTableStats() const;
+    std::string makeDisplayName(int pid, std::string_view comm) const;
+    bool readProcessInfoFromProc(ScanShard& shard, int pid, const TaskstatsSample* sample, ProcessInfo& info);
+    void applyDeltas(ScanShard& shard, int pid, unsigned long long startTime, std::string_view comm,
+                     const ProcessCounters& current, ProcessInfo& info);
+    uint32_t cachedName(ProcessDelta& entry, bool fresh, int pid, std::string_view comm);
+    static void computeRates(const ProcessCounters& last, const ProcessCounters& current, ProcessInfo& info);
+    long pageSize;
+    long clockTicks;
+    ThreadSampler threadSampler;
+    std::vector<int> configExpandedPids;
+    std::shared_ptr<const std::vector<int>> expandedPids;
+    std::vector<int> threadPids;
+    std::shared_ptr<const MemorySampler> memory;
+    std::shared_ptr<const PacketFlowMonitor> network;
     static constexpr double CPU_WEIGHT = 0.4;
     static constexpr double MEMORY_WEIGHT = 0.4;
     static constexpr double DISK_WEIGHT = 0.2;
     static constexpr size_t MAX_NAME_LENGTH = 15;
     static constexpr size_t TRUNCATE_LENGTH = 12;
+    static constexpr size_t SORT_HEADROOM = 32;
+    static constexpr std::chrono::milliseconds RENAME_PUBLISH_INTERVAL{250};
 };
\ No newline at end of file
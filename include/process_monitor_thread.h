@@ -1,23 +1,31 @@
 #pragma once
 
 #include "process_monitor.h"
+#include "self_stats.h"
+#include <chrono>
 #include <thread>
-#include <mutex>
 #include <atomic>
 
 class ProcessMonitorThread {
 public:
-    ProcessMonitorThread(int updateInterval);
+    // scans are timed into stats as "processes"
+    ProcessMonitorThread(const Config& config, std::shared_ptr<const MemorySampler> memory, SelfStats& stats,
+                         std::shared_ptr<const PacketFlowMonitor> network = nullptr);
     ~ProcessMonitorThread();
     void start();
     void stop();
-    std::vector<ProcessInfo> getProcesses() const;
+    std::shared_ptr<const ProcessSnapshot> getProcesses(size_t visibleRows) const;
+    ProcessDeltaTable::Stats getDeltaTableStats() const;
+    void setExpandedPids(const std::vector<int>& pids) const;
 
 private:
     void run();
+    // returns when the next scan was due
+    std::chrono::steady_clock::time_point waitForNextUpdate();
     mutable ProcessMonitor processMonitor;
+    SelfStat& scanStat;
+    SelfStat& eventStat;
     std::thread monitorThread;
-    mutable std::mutex processesMutex;
     std::atomic<bool> running;
     int updateInterval;
 };
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// File I/O charged to whatever is being measured on this thread. proc_io, NetlinkSocket and
+// the /proc directory scans count into it; std::ifstream reads are not counted.
+struct IoTally {
+    std::atomic<uint64_t> opens{0};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> bytesRead{0};
+};
+
+// null while nothing on this thread is being measured
+inline thread_local IoTally* currentIoTally = nullptr;
+
+inline void countFileOpen() {
+    if (currentIoTally) currentIoTally->opens.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void countRead(size_t bytes) {
+    if (currentIoTally) {
+        currentIoTally->reads.fetch_add(1, std::memory_order_relaxed);
+        currentIoTally->bytesRead.fetch_add(bytes, std::memory_order_relaxed);
+    }
+}
+
+// HDR-style histogram of nanosecond durations: every power of two is split into 16 linear
+// sub-buckets, so any value up to ~18 minutes lands in a bucket within 1/16 of it, in 592
+// fixed counters. record() is a few shifts and relaxed atomic adds, and readers can take
+// quantiles while writers keep recording.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(uint64_t nanoseconds);
+    uint64_t count() const;
+    uint64_t max() const;
+    double mean() const;
+    // upper edge of the bucket holding the q-quantile, 0 when empty
+    uint64_t quantile(double q) const;
+
+private:
+    static constexpr unsigned SUB_BUCKET_BITS = 4;
+    static constexpr unsigned MAX_EXPONENT = 39;
+    static constexpr size_t BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) << SUB_BUCKET_BITS;
+
+    std::atomic<uint64_t> buckets[BUCKET_COUNT];
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> largest;
+
+    static size_t bucketOf(uint64_t value);
+    static uint64_t bucketUpperEdge(size_t bucket);
+};
+
+struct SelfStat {
+    explicit SelfStat(std::string name) : name(std::move(name)) {}
+
+    std::string name;
+    LatencyHistogram latency;
+    // how late each run started against its schedule; empty for unscheduled work
+    LatencyHistogram jitter;
+    IoTally io;
+};
+
+// The monitor's own cost, per collector and per display panel. Entries are created on first
+// use and live as long as the registry, so callers may keep the reference.
+class SelfStats {
+public:
+    SelfStat& get(const std::string& name);
+    // in order of first use
+    std::vector<const SelfStat*> all() const;
+    // one line per entry, for --self-stats
+    std::string report() const;
+
+private:
+    mutable std::mutex mutex;
+    std::deque<SelfStat> stats;
+    std::unordered_map<std::string, SelfStat*> byName;
+};
+
+// Times the enclosing block into stat and charges the thread's file I/O meanwhile to it.
+// With a scheduled time, also records how late the block started.
+class SelfStatScope {
+public:
+    explicit SelfStatScope(SelfStat& stat);
+    SelfStatScope(SelfStat& stat, std::chrono::steady_clock::time_point scheduled);
+    ~SelfStatScope();
+    SelfStatScope(const SelfStatScope&) = delete;
+    SelfStatScope& operator=(const SelfStatScope&) = delete;
+
+private:
+    SelfStat& stat;
+    IoTally* previous;
+    std::chrono::steady_clock::time_point start;
+};
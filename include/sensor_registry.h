@@ -0,0 +1,61 @@
+#pragma once
+
+#include "cpu_sampler.h"
+#include "netlink_socket.h"
+#include <optional>
+#include <string>
+#include <vector>
+
+enum class SensorKind {
+    Core,
+    Package,
+    Nvme
+};
+
+struct TemperatureSensor {
+    SensorKind kind;
+    // "Package id 0", "Core 3", "nvme0", ...
+    std::string label;
+    double celsius;
+    bool valid;
+};
+
+// Maps temperature inputs to logical CPUs, packages and NVMe drives once, from the hwmon
+// name and temp*_label files, and keeps every input and each CPU's scaling_cur_freq open so
+// a refresh is one pread per file. Discovery runs again only after a CPU, hwmon or NVMe
+// hotplug uevent, a change in the number of online CPUs, or a sensor read failing.
+class SensorRegistry {
+public:
+    explicit SensorRegistry(std::string sysfsRoot = "/sys");
+    ~SensorRegistry();
+    SensorRegistry(const SensorRegistry&) = delete;
+    SensorRegistry& operator=(const SensorRegistry&) = delete;
+
+    // cores is CpuSampler::cores(); offline CPUs are not read
+    void update(const std::vector<CpuBreakdown>& cores);
+    std::optional<double> coreTemperature(size_t cpu) const;
+    // GHz
+    std::optional<double> coreFrequency(size_t cpu) const;
+    const std::vector<TemperatureSensor>& sensors() const;
+    size_t discoveryCount() const;
+
+private:
+    std::string sysfsRoot;
+    std::vector<TemperatureSensor> sensorList;
+    std::vector<int> sensorFds;
+    // per logical CPU: index into sensorList (core sensor, else its package), or -1
+    std::vector<int> cpuSensors;
+    std::vector<int> frequencyFds;
+    std::vector<double> frequencies;
+    NetlinkSocket uevents;
+    std::vector<char> ueventBuffer;
+    std::string buffer;
+    bool rediscoverPending;
+    size_t discoveredOnlineCount;
+    size_t discoveries;
+
+    void discover(const std::vector<CpuBreakdown>& cores);
+    void closeAll();
+    bool drainUevents();
+    int addSensor(SensorKind kind, std::string label, const std::string& inputPath);
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "netlink_socket.h"
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <linux/inet_diag.h>
+
+// Dumps the sockets of one protocol over NETLINK_SOCK_DIAG, IPv4 and IPv6 in one batched
+// request, calling fn(message, attributes, attributesLength) for each. extensions is the
+// idiag_ext mask (1 << (INET_DIAG_INFO - 1), ...). TIME_WAIT and half-open request sockets
+// are left out: no process owns them.
+bool dumpInetSockets(NetlinkSocket& socket, uint8_t protocol, uint8_t extensions,
+                     std::vector<char>& requestBuffer, std::vector<char>& receiveBuffer,
+                     const std::function<void(const struct inet_diag_msg&, const void*, size_t)>& fn,
+                     std::string& error);
+
+// Socket inode -> pid, built from /proc/<pid>/fd. update() only touches /proc when it is
+// given an inode it cannot place, and then only reads the fds a process opened since the
+// last look. Only if that still leaves inodes unplaced are all fds re-read, and then only for
+// processes of the sockets' owning users.
+class SocketOwnerIndex {
+public:
+    struct Socket {
+        unsigned long long inode;
+        unsigned int uid;
+    };
+
+    SocketOwnerIndex();
+
+    // live is every socket that currently exists; owners of the others are forgotten
+    void update(const std::vector<Socket>& live);
+    // 0 when no process we can see holds the socket
+    int ownerOf(unsigned long long inode) const;
+    // comm of a pid seen by the last scan, or "(unknown)"
+    const std::string& processName(int pid) const;
+    // how many /proc/<pid>/fd links have been read, for judging the index's cost
+    unsigned long long fdLinksRead() const;
+
+private:
+    struct Owner {
+        int pid;
+        int fd;
+    };
+
+    struct OwnerProcess {
+        std::string name;
+        // fd numbers already looked at, sorted
+        std::vector<int> fds;
+        bool seen;
+    };
+
+    std::unordered_map<unsigned long long, Owner> owners;
+    std::unordered_map<int, OwnerProcess> ownerProcesses;
+    // inodes a full pass could not place (other namespaces, unreadable fd tables); not retried
+    std::unordered_set<unsigned long long> unowned;
+    std::unordered_set<unsigned long long> liveInodes;
+    std::unordered_set<unsigned int> unplacedUids;
+    std::vector<int> currentFds;
+    std::string buffer;
+    unsigned long long linksRead;
+
+    // fills unplacedUids with the owners of sockets not yet matched to a process
+    bool findUnplaced(const std::vector<Socket>& live);
+    void scanOwners(bool full);
+    void scanProcess(int pid, OwnerProcess& process, bool full);
+    void pruneOwners();
+};
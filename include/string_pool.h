@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+// Append-only pool of short strings, each stored once and named by a 32-bit id. Strings live in
+// fixed-size blocks that never move, listed in a fixed directory, so get() needs no lock and may
+// run concurrently with intern() for any id the caller received after it was interned.
+class StringPool {
+public:
+    static constexpr uint32_t EMPTY_ID = 0;
+
+    StringPool();
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    // Returns EMPTY_ID once every block is full; strings longer than MAX_LENGTH are truncated.
+    uint32_t intern(std::string_view text);
+    std::string_view get(uint32_t id) const;
+    // true once intern() has turned a string away for lack of space
+    bool isFull() const;
+    size_t size() const;
+    size_t memoryBytes() const;
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    static constexpr size_t MAX_BLOCKS = 256;
+    static constexpr size_t MAX_LENGTH = 255;
+
+    std::array<std::unique_ptr<char[]>, MAX_BLOCKS> blocks;
+    size_t blockCount;
+    size_t blockUsed;
+    std::unordered_map<std::string_view, uint32_t> index;
+    std::atomic<bool> full;
+    mutable std::mutex mutex;
+};
@@ -6,41 +6,71 @@
 #include "logger.h"
 #include "network_monitor.h"
 #include "battery_monitor.h"
+#include "cpu_sampler.h"
+#include "sensor_registry.h"
+#include "memory_sampler.h"
+#include "mount_monitor.h"
+#include "disk_io_monitor.h"
+#include "pressure_monitor.h"
+#include "cgroup_monitor.h"
+#include "connection_monitor.h"
+#include "packet_flow_monitor.h"
+#include "collector_scheduler.h"
+#include "metric_history.h"
 #include <string>
 #include <vector>
+#include <array>
 #include <optional>
+#include <unordered_map>
 #include <filesystem>
 #include <memory>
+#include <shared_mutex>
 #include <sys/sysinfo.h>
 
 class Display;
+class MetricWriter;
 
 struct CPUCoreInfo {
     double utilization;
     double temperature;
     double clockSpeed;
+    CpuBreakdown breakdown;
 };
 
-struct DiskPartitionInfo {
-    std::string name;
-    std::string mountPoint;
-    unsigned long long totalSpace;
-    unsigned long long usedSpace;
-};
-
+// Each collector samples on its own cadence on the scheduler's threads and then publishes its
+// results into the fields the getters return, under stateMutex. Getters are for the UI thread,
+// which holds the lock shared while it reads them (see run()).
 class SystemMonitor {
 public:
-    SystemMonitor(const Config& config, std::shared_ptr<Logger> logger, Display& display, bool nvml_available);
+    // every collector run is timed into selfStats under the collector's name; a null display
+    // runs headless, without the process table and with run() streaming records instead
+    SystemMonitor(const Config& config, std::shared_ptr<Logger> logger, Display* display, bool nvml_available,
+                  SelfStats& selfStats);
     bool initialize();
+    // Runs every collector once on the calling thread; only while the scheduler is stopped.
     void update();
     [[nodiscard]] double getCpuUsage() const;
+    [[nodiscard]] const CpuBreakdown& getCpuBreakdown() const;
     [[nodiscard]] const std::vector<CPUCoreInfo>& getCPUCoreInfo() const;
+    [[nodiscard]] const std::vector<TemperatureSensor>& getTemperatureSensors() const;
     [[nodiscard]] double getMemoryUsage() const;
+    [[nodiscard]] const MemoryInfo& getMemoryInfo() const;
     [[nodiscard]] double getDiskUsage() const;
     [[nodiscard]] const std::vector<DiskPartitionInfo>& getDiskPartitions() const;
-    [[nodiscard]] std::vector<ProcessInfo> getProcesses() const;
-    [[nodiscard]] std::vector<GPUInfo> getGPUInfo() const;
-    [[nodiscard]] std::vector<NetworkInterface> getNetworkInterfaces() const;
+    [[nodiscard]] const std::vector<DiskIOStats>& getDiskIOStats() const;
+    [[nodiscard]] const ResourcePressure& getPressure(PressureResource resource) const;
+    // same view hint as getProcesses: only the first visibleRows cgroups get their details read
+    [[nodiscard]] const std::vector<CgroupInfo>& getCgroups(size_t visibleRows) const;
+    [[nodiscard]] size_t getCgroupCount() const;
+    [[nodiscard]] const std::vector<TcpConnection>& getConnections() const;
+    [[nodiscard]] const std::vector<ProcessConnections>& getConnectionsByProcess() const;
+    // visibleRows is how far down the list the caller will read; rows past it may be unordered
+    [[nodiscard]] std::shared_ptr<const ProcessSnapshot> getProcesses(size_t visibleRows) const;
+    [[nodiscard]] ProcessDeltaTable::Stats getProcessDeltaStats() const;
+    // view hint like visibleRows: which processes the display shows threads for
+    void setExpandedPids(const std::vector<int>& pids) const;
+    [[nodiscard]] const std::vector<GPUInfo>& getGPUInfo() const;
+    [[nodiscard]] const std::vector<NetworkInterface>& getNetworkInterfaces() const;
     [[nodiscard]] bool isAlertTriggered() const;
     [[nodiscard]] bool isGPUMonitoringAvailable() const;
     [[nodiscard]] std::string getCpuModel() const;
@@ -49,42 +79,109 @@ public:
     [[nodiscard]] std::string getDiskName() const;
     [[nodiscard]] const BatteryMonitor& getBatteryMonitor() const;
     [[nodiscard]] long getUptime() const;
-    void run();
+    // series are named "cpu", "cpu.core<N>", "memory", "disk", "diskio.<device>.util",
+    // "net.<interface>.rx" / ".tx", "gpu.<index>.util" / ".temp" and "psi.<resource>.some"
+    [[nodiscard]] const MetricHistory& getHistory() const;
+    // Until 'q' with a display. Headless, writes one record to records every
+    // record_interval_ms until SIGINT or SIGTERM, which the caller must have blocked.
+    void run(MetricWriter* records = nullptr);
     static const float GPU_TEMP_THRESHOLD;
 
 private:
+    // published state, written by collectors under stateMutex
+    mutable std::shared_mutex stateMutex;
     double cpuUsage;
+    CpuBreakdown cpuBreakdown;
     std::vector<CPUCoreInfo> cpuCoreInfo;
+    std::vector<TemperatureSensor> temperatureSensors;
     double memoryUsage;
+    MemoryInfo memoryInfo;
     double diskUsage;
     std::vector<DiskPartitionInfo> diskPartitions;
+    std::vector<DiskIOStats> diskIOStats;
+    std::vector<GPUInfo> gpuInfo;
+    std::vector<NetworkInterface> networkInterfaces;
+    BatteryMonitor battery;
+    std::vector<TcpConnection> connections;
+    std::vector<ProcessConnections> connectionsByProcess;
+    std::vector<CgroupInfo> cgroupRows;
+    size_t cgroupCount;
+    MetricHistory history;
+    bool historyFullLogged;
+    // getProcesses runs on the UI thread only
+    mutable bool namePoolFullLogged;
+    // history ids, kept so publishing builds no names; links and disks are retired when they go away
+    struct LinkSeries {
+        std::string name;
+        MetricHistory::SeriesId receive;
+        MetricHistory::SeriesId send;
+        bool seen;
+    };
+    struct DeviceSeries {
+        MetricHistory::SeriesId utilization;
+        bool seen;
+    };
+    MetricHistory::SeriesId cpuSeries;
+    MetricHistory::SeriesId memorySeries;
+    MetricHistory::SeriesId diskSeries;
+    std::array<MetricHistory::SeriesId, 3> pressureSeries;
+    std::vector<MetricHistory::SeriesId> coreSeries;
+    std::vector<std::pair<MetricHistory::SeriesId, MetricHistory::SeriesId>> gpuSeries;
+    std::unordered_map<int, LinkSeries> linkSeries;
+    std::unordered_map<std::string, DeviceSeries> deviceSeries;
     bool alertTriggered;
     bool nvml_available;
     bool gpuUnavailabilityLogged;
     const Config& config;
+    // shared with the process monitor, which only reads MemTotal from it
+    std::shared_ptr<MemorySampler> memorySampler;
+    // null unless packet_capture_enabled; feeds per-process traffic into the process table
+    std::shared_ptr<PacketFlowMonitor> packetFlowMonitor;
     ProcessMonitorThread processMonitorThread;
     GPUMonitor gpuMonitor;
     NetworkMonitor networkMonitor;
     BatteryMonitor batteryMonitor;
+    CpuSampler cpuSampler;
+    SensorRegistry sensorRegistry;
+    MountMonitor mountMonitor;
+    DiskIOMonitor diskIOMonitor;
+    PressureMonitor pressureMonitor;
+    // sampled outside the lock; only its row hint is touched from the UI thread
+    mutable CgroupMonitor cgroupMonitor;
+    ConnectionMonitor connectionMonitor;
+    // collectors' own buffers, filled before publishing
+    std::vector<CPUCoreInfo> sampledCores;
+    std::vector<DiskPartitionInfo> sampledPartitions;
     std::shared_ptr<Logger> logger;
-    Display& display;
+    Display* display;
+    SelfStat& outputStat;
     std::string cpuModel;
     unsigned long long totalMemory;
     unsigned long long totalDiskSpace;
     std::string diskName;
     long uptime;
+    // declared after everything the collectors touch, so it stops before they are destroyed
+    CollectorScheduler scheduler;
+    bool scheduled;
 
-    [[nodiscard]] double calculateCpuUsage();
-    void updateCPUCoreInfo();
-    [[nodiscard]] double calculateMemoryUsage();
-    [[nodiscard]] double calculateDiskUsage();
-    void updateDiskPartitions();
+    void collectCpu();
+    void collectMemory();
+    void collectDisk();
+    void collectGpu();
+    void collectNetwork();
+    void collectBattery();
+    void collectUptime();
+    void collectPressure();
+    void collectCgroups();
+    void collectConnections();
+    // creates a history series sized for the collector's interval; under stateMutex
+    MetricHistory::SeriesId historySeries(const std::string& name, const char* collector);
     [[nodiscard]] std::optional<std::vector<long long>> getSystemStats();
     void checkAlerts();
+    void reportStalls(const std::vector<PressureResource>& stalls);
     bool initializeGPU();
     void initializeCpuInfo();
     void initializeMemoryInfo();
     void initializeDiskInfo();
     std::string getRootDeviceName();
-    void updateUptime();
 };
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "netlink_socket.h"
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <string>
+#include <vector>
+
+struct TaskstatsSample {
+    int pid;
+    int tgid;
+    std::string comm;
+    unsigned long long cpuTimeUs;
+    unsigned long long cpuDelayNs;
+    unsigned long long blkioDelayNs;
+    unsigned long long swapinDelayNs;
+    unsigned long long readBytes;
+    unsigned long long writeBytes;
+    unsigned long long startTime;
+};
+
+// Per-task accounting over the TASKSTATS generic netlink family. Queries are pipelined: a whole
+// batch of requests goes out in one send() and the replies are collected with recvmmsg().
+// TASKSTATS_CMD_GET needs CAP_NET_ADMIN, which open() checks up front.
+class TaskstatsClient {
+public:
+    TaskstatsClient();
+
+    bool open(std::string& error);
+    bool isOpen() const;
+
+    // Fills samples[i] for tgids[i] and sets valid[i]; a tgid that has exited comes back invalid.
+    // CPU time and delays are summed over all threads; comm and start time come from the leader.
+    void query(const std::vector<int>& tgids, std::vector<TaskstatsSample>& samples, std::vector<char>& valid);
+
+    // Subscribes to the per-CPU exit records so processes that end between ticks are still seen.
+    bool listenForExits(std::string& error);
+    int exitFd() const;
+    void drainExits(std::vector<TaskstatsSample>& exited);
+
+private:
+    NetlinkSocket querySocket;
+    NetlinkSocket exitSocket;
+    uint16_t familyId;
+    std::vector<char> requestBuffer;
+    std::vector<char> receiveBuffer;
+    std::vector<char> replyBuffers;
+    std::vector<struct iovec> replyVectors;
+    std::vector<struct mmsghdr> replyMessages;
+    std::vector<char> replySeen;
+
+    bool resolveFamily(std::string& error);
+    void queueRequest(NetlinkMessageWriter& writer, uint16_t attribute, int id, uint32_t sequence, uint16_t flags);
+    static constexpr int HAS_TASK = 1;
+    static constexpr int HAS_GROUP = 2;
+    // Returns a mask of HAS_TASK / HAS_GROUP. Group totals take precedence for CPU and delays;
+    // comm, start time and I/O always come from the task part.
+    int parseReply(const struct nlmsghdr* header, TaskstatsSample& sample) const;
+};
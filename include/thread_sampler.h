@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include "process_delta_table.h"
+#include "string_pool.h"
+
+struct ThreadInfo {
+    int tid;
+    uint32_t nameId;
+    char state;
+    double cpuUsage;
+};
+
+// The threads of one expanded process, as a range of the snapshot's thread list.
+struct ThreadGroup {
+    int pid;
+    uint32_t first;
+    uint32_t count;
+};
+
+// Samples /proc/<pid>/task/<tid>/stat for the few processes the user has expanded. Per-thread CPU
+// deltas are keyed by (tid, start time) and dropped once a thread is no longer listed; nothing
+// under /proc/<pid>/task is read while no process is expanded.
+class ThreadSampler {
+public:
+    ThreadSampler(std::shared_ptr<StringPool> names, long clockTicks);
+
+    // Fills threads with every thread of pids, busiest first within each process, and groups with
+    // one range per process that could be read.
+    void sample(const std::vector<int>& pids, std::chrono::steady_clock::time_point now,
+                std::vector<ThreadInfo>& threads, std::vector<ThreadGroup>& groups);
+
+private:
+    std::shared_ptr<StringPool> names;
+    long clockTicks;
+    ProcessDeltaTable deltas;
+    std::string path;
+    std::string buffer;
+
+    static constexpr size_t MAX_DELTA_BYTES = 1024 * 1024;
+
+    void sampleProcess(int pid, std::chrono::steady_clock::time_point now, std::vector<ThreadInfo>& threads);
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "self_stats.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool for fork/join work. The calling thread takes part in parallelFor, so a pool of
+// size 1 starts no threads at all and simply runs the tasks inline.
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t threadCount);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+    size_t size() const;
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+    const std::function<void(size_t)>* currentTask;
+    // the caller's I/O tally, so work done on the pool is charged to whatever it is measuring
+    IoTally* currentTally;
+    size_t taskCount;
+    std::atomic<size_t> nextIndex;
+    size_t activeWorkers;
+    unsigned long long batch;
+    bool stopping;
+
+    void workerLoop();
+    void runTasks();
+};
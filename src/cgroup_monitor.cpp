@@ -0,0 +1,275 @@
+#include "../include/cgroup_monitor.h"
+#include "../include/proc_io.h"
+#include "../include/proc_parsers.h"
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace {
+
+const char* const CGROUP_FILES[] = {"cpu.stat", "memory.current", "memory.stat", "io.stat", "pids.current"};
+
+// only directories matter: a cgroup is a directory, and its interface files never change
+constexpr uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+
+std::string findCgroupRoot() {
+    std::error_code ec;
+    for (const char* candidate : {"/sys/fs/cgroup", "/sys/fs/cgroup/unified"}) {
+        if (std::filesystem::exists(std::string(candidate) + "/cgroup.controllers", ec)) {
+            return candidate;
+        }
+    }
+    return "";
+}
+
+// Calls fn(key, rest) for each "key value..." line, as in cpu.stat and memory.stat.
+template<typename Fn>
+void forEachKey(std::string_view content, Fn fn) {
+    while (!content.empty()) {
+        std::string_view line = nextLine(content);
+        std::string_view key = nextToken(line);
+        fn(key, line);
+    }
+}
+
+unsigned long long delta(unsigned long long before, unsigned long long after) {
+    return after > before ? after - before : 0;
+}
+
+}
+
+CgroupMonitor::CgroupMonitor()
+    : root(findCgroupRoot()), detailRows(DEFAULT_DETAIL_ROWS), inotifyFd(-1), rewalkNeeded(true),
+      watchesComplete(false), ticksSinceWalk(0) {}
+
+CgroupMonitor::~CgroupMonitor() {
+    for (auto& cgroup : cgroups) {
+        closeFiles(cgroup);
+    }
+    if (inotifyFd >= 0) {
+        close(inotifyFd);
+    }
+}
+
+bool CgroupMonitor::isAvailable() const {
+    return !root.empty();
+}
+
+size_t CgroupMonitor::cgroupCount() const {
+    return cgroups.size();
+}
+
+void CgroupMonitor::setDetailRows(size_t visibleRows) {
+    detailRows.store(visibleRows, std::memory_order_relaxed);
+}
+
+const std::vector<CgroupInfo>& CgroupMonitor::getCgroups() const {
+    return rows;
+}
+
+void CgroupMonitor::update() {
+    if (root.empty()) {
+        return;
+    }
+    if (drainEvents()) {
+        rewalkNeeded = true;
+    }
+    if (!watchesComplete && ++ticksSinceWalk >= RESCAN_TICKS) {
+        rewalkNeeded = true;
+    }
+    if (rewalkNeeded) {
+        walk();
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    double elapsedUsec = std::chrono::duration<double, std::micro>(now - lastUpdate).count();
+    for (auto& cgroup : cgroups) {
+        auto& info = cgroup.info;
+        auto content = readFile(cgroup, CPU_STAT);
+        info.hasCpu = content.has_value();
+        if (content) {
+            // the root cgroup has no cpu.max, so its throttling keys are simply absent
+            unsigned long long usage = 0, throttled = 0, periods = 0;
+            forEachKey(*content, [&](std::string_view key, std::string_view value) {
+                if (key == "usage_usec") parseUnsigned(value, usage);
+                else if (key == "throttled_usec") parseUnsigned(value, throttled);
+                else if (key == "nr_throttled") parseUnsigned(value, periods);
+            });
+            if (cgroup.cpuValid && elapsedUsec > 0) {
+                info.cpuUsage = 100.0 * static_cast<double>(delta(cgroup.usageUsec, usage)) / elapsedUsec;
+                info.throttledPercent = 100.0 * static_cast<double>(delta(cgroup.throttledUsec, throttled)) / elapsedUsec;
+                info.throttledPeriods = delta(cgroup.nrThrottled, periods);
+            }
+            cgroup.usageUsec = usage;
+            cgroup.throttledUsec = throttled;
+            cgroup.nrThrottled = periods;
+        }
+        cgroup.cpuValid = info.hasCpu;
+
+        content = readFile(cgroup, MEMORY_CURRENT);
+        std::string_view memory = content ? *content : std::string_view();
+        info.hasMemory = content && parseUnsigned(memory, info.memoryCurrent);
+    }
+
+    // same partial ordering as the process list: only the rows the view can show are ranked
+    order.resize(cgroups.size());
+    for (size_t i = 0; i < cgroups.size(); ++i) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+    size_t count = std::min(detailRows.load(std::memory_order_relaxed), order.size());
+    auto busier = [this](uint32_t a, uint32_t b) { return cgroups[a].info.cpuUsage > cgroups[b].info.cpuUsage; };
+    if (count < order.size()) {
+        std::nth_element(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(count), order.end(), busier);
+    }
+    std::sort(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(count), busier);
+
+    rows.clear();
+    for (size_t i = 0; i < count; ++i) {
+        auto& cgroup = cgroups[order[i]];
+        readDetails(cgroup, now);
+        rows.push_back(cgroup.info);
+    }
+    lastUpdate = now;
+}
+
+void CgroupMonitor::readDetails(Cgroup& cgroup, std::chrono::steady_clock::time_point now) {
+    auto& info = cgroup.info;
+    if (auto content = readFile(cgroup, MEMORY_STAT)) {
+        forEachKey(*content, [&](std::string_view key, std::string_view value) {
+            if (key == "anon") parseUnsigned(value, info.memoryAnon);
+            else if (key == "file") parseUnsigned(value, info.memoryFile);
+        });
+    }
+
+    auto content = readFile(cgroup, IO_STAT);
+    info.hasIo = content.has_value();
+    if (content) {
+        // one "major:minor rbytes=... wbytes=... rios=..." line per device the cgroup touched
+        unsigned long long readBytes = 0, writeBytes = 0;
+        forEachKey(*content, [&](std::string_view, std::string_view fields) {
+            while (!fields.empty()) {
+                std::string_view field = nextToken(fields);
+                std::string_view number = field.substr(std::min<size_t>(field.size(), 7));
+                unsigned long long value;
+                if (field.compare(0, 7, "rbytes=") == 0 && parseUnsigned(number, value)) {
+                    readBytes += value;
+                } else if (field.compare(0, 7, "wbytes=") == 0 && parseUnsigned(number, value)) {
+                    writeBytes += value;
+                }
+            }
+        });
+        // rows that were off screen for a while get a rate averaged over that whole time
+        double seconds = std::chrono::duration<double>(now - cgroup.ioTime).count();
+        if (cgroup.ioValid && seconds > 0) {
+            info.ioReadBytesPerSec = static_cast<double>(delta(cgroup.ioRead, readBytes)) / seconds;
+            info.ioWriteBytesPerSec = static_cast<double>(delta(cgroup.ioWrite, writeBytes)) / seconds;
+        }
+        cgroup.ioRead = readBytes;
+        cgroup.ioWrite = writeBytes;
+        cgroup.ioTime = now;
+    }
+    cgroup.ioValid = info.hasIo;
+
+    content = readFile(cgroup, PIDS_CURRENT);
+    std::string_view pids = content ? *content : std::string_view();
+    info.hasPids = content && parseUnsigned(pids, info.pids);
+}
+
+std::optional<std::string_view> CgroupMonitor::readFile(Cgroup& cgroup, CgroupFile file) {
+    int& fd = cgroup.fds[file];
+    if (fd == UNAVAILABLE) {
+        return std::nullopt;
+    }
+    if (fd == NOT_OPENED) {
+        // files of controllers not enabled for this cgroup do not exist
+        fd = openProcFile(root + cgroup.info.path + "/" + CGROUP_FILES[file]);
+        if (fd < 0) {
+            fd = UNAVAILABLE;
+            return std::nullopt;
+        }
+    }
+    return readProcFile(fd, buffer);
+}
+
+void CgroupMonitor::walk() {
+    std::unordered_map<std::string, size_t> known;
+    for (size_t i = 0; i < cgroups.size(); ++i) {
+        known.emplace(cgroups[i].info.path, i);
+    }
+
+    // a fresh inotify instance drops the watches of removed cgroups along with the rest
+    if (inotifyFd >= 0) {
+        close(inotifyFd);
+    }
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    watchesComplete = inotifyFd >= 0;
+
+    std::vector<Cgroup> next;
+    next.reserve(cgroups.size());
+    auto visit = [&](std::string path, int depth) {
+        if (watchesComplete && inotify_add_watch(inotifyFd, (root + path).c_str(), WATCH_MASK) < 0) {
+            // typically ENOSPC from fs.inotify.max_user_watches
+            watchesComplete = false;
+        }
+        auto existing = known.find(path);
+        if (existing != known.end()) {
+            Cgroup& kept = cgroups[existing->second];
+            next.push_back(kept);
+            kept.fds.fill(NOT_OPENED);
+            // a controller may have been enabled since; look for its files again
+            for (int& fd : next.back().fds) {
+                if (fd == UNAVAILABLE) fd = NOT_OPENED;
+            }
+            return;
+        }
+        Cgroup cgroup = {};
+        cgroup.info.path = std::move(path);
+        cgroup.info.depth = depth;
+        cgroup.fds.fill(NOT_OPENED);
+        next.push_back(std::move(cgroup));
+    };
+
+    visit("/", 0);
+    std::error_code ec;
+    std::filesystem::recursive_directory_iterator it(root, std::filesystem::directory_options::skip_permission_denied, ec);
+    for (; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        if (it->is_directory(ec)) {
+            visit(it->path().string().substr(root.size()), it.depth() + 1);
+        }
+    }
+
+    for (auto& cgroup : cgroups) {
+        closeFiles(cgroup);
+    }
+    cgroups = std::move(next);
+    rewalkNeeded = false;
+    ticksSinceWalk = 0;
+}
+
+bool CgroupMonitor::drainEvents() {
+    if (inotifyFd < 0) {
+        return false;
+    }
+    if (eventBuffer.size() < 4096) {
+        eventBuffer.resize(4096);
+    }
+    // every event in the mask (and IN_Q_OVERFLOW) means the tree changed; the details don't matter
+    bool changed = false;
+    while (read(inotifyFd, eventBuffer.data(), eventBuffer.size()) > 0) {
+        changed = true;
+    }
+    return changed;
+}
+
+void CgroupMonitor::closeFiles(Cgroup& cgroup) {
+    for (int& fd : cgroup.fds) {
+        if (fd >= 0) {
+            closeProcFile(fd);
+        }
+        fd = NOT_OPENED;
+    }
+}
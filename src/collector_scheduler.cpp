@@ -0,0 +1,199 @@
+#include "../include/collector_scheduler.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+namespace {
+
+constexpr uint64_t STOP_EVENT = UINT64_MAX;
+
+}
+
+CollectorScheduler::CollectorScheduler(size_t threadCount, SelfStats& stats)
+    : threadCount(threadCount < 1 ? 1 : threadCount), stats(stats), epollFd(-1), stopFd(-1), doneFd(-1), stopping(false) {}
+
+CollectorScheduler::~CollectorScheduler() {
+    stop();
+}
+
+void CollectorScheduler::add(std::string name, int periodMs, std::function<void()> collect) {
+    SelfStat* stat = &stats.get(name);
+    collectors.push_back({std::move(name), periodMs < 1 ? 1 : periodMs, std::move(collect), stat, -1, {}, false, 0});
+}
+
+void CollectorScheduler::runAll() {
+    for (auto& collector : collectors) {
+        SelfStatScope scope(*collector.stat);
+        collector.collect();
+    }
+}
+
+bool CollectorScheduler::start(std::string& error) {
+    if (dispatcher.joinable()) {
+        return true;
+    }
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    stopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    doneFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epollFd < 0 || stopFd < 0 || doneFd < 0) {
+        error = std::string("epoll/eventfd: ") + strerror(errno);
+        closeFds();
+        return false;
+    }
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = STOP_EVENT;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, stopFd, &event);
+
+    // absolute expiries on the steady clock (CLOCK_MONOTONIC), so each run's lateness is exact
+    auto base = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < collectors.size(); ++i) {
+        auto& collector = collectors[i];
+        collector.due = base;
+        auto first = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            (base + std::chrono::milliseconds(collector.periodMs)).time_since_epoch()).count();
+        collector.timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+        struct itimerspec period = {};
+        period.it_interval.tv_sec = collector.periodMs / 1000;
+        period.it_interval.tv_nsec = static_cast<long>(collector.periodMs % 1000) * 1000000;
+        period.it_value.tv_sec = static_cast<time_t>(first / 1000000000);
+        period.it_value.tv_nsec = static_cast<long>(first % 1000000000);
+        event.data.u64 = i;
+        if (collector.timerFd < 0 || timerfd_settime(collector.timerFd, TFD_TIMER_ABSTIME, &period, nullptr) != 0 ||
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, collector.timerFd, &event) != 0) {
+            error = "timer for " + collector.name + ": " + strerror(errno);
+            closeFds();
+            return false;
+        }
+    }
+
+    stopping = false;
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&CollectorScheduler::workerLoop, this);
+    }
+    dispatcher = std::thread(&CollectorScheduler::dispatch, this);
+    return true;
+}
+
+void CollectorScheduler::stop() {
+    if (!dispatcher.joinable()) {
+        return;
+    }
+    uint64_t one = 1;
+    ssize_t written = write(stopFd, &one, sizeof(one));
+    (void)written;
+    dispatcher.join();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        queue.clear();
+    }
+    ready.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    for (auto& collector : collectors) {
+        collector.busy = false;
+    }
+    closeFds();
+}
+
+int CollectorScheduler::readyFd() const {
+    return doneFd;
+}
+
+unsigned long long CollectorScheduler::skippedTicks(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& collector : collectors) {
+        if (collector.name == name) {
+            return collector.skipped;
+        }
+    }
+    return 0;
+}
+
+void CollectorScheduler::dispatch() {
+    struct epoll_event events[16];
+    while (true) {
+        int count = epoll_wait(epollFd, events, 16, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        bool queued = false;
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.u64 == STOP_EVENT) {
+                return;
+            }
+            auto& collector = collectors[events[i].data.u64];
+            uint64_t expirations = 0;
+            if (read(collector.timerFd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            collector.due += std::chrono::milliseconds(collector.periodMs) * expirations;
+            // ticks missed while the dispatcher itself was descheduled count as skipped too
+            collector.skipped += expirations - 1;
+            if (collector.busy) {
+                ++collector.skipped;
+                continue;
+            }
+            collector.busy = true;
+            queue.push_back(static_cast<size_t>(events[i].data.u64));
+            queued = true;
+        }
+        if (queued) {
+            ready.notify_all();
+        }
+    }
+}
+
+void CollectorScheduler::workerLoop() {
+    while (true) {
+        size_t index;
+        std::chrono::steady_clock::time_point due;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) return;
+            index = queue.front();
+            queue.pop_front();
+            due = collectors[index].due;
+        }
+        {
+            SelfStatScope scope(*collectors[index].stat, due);
+            collectors[index].collect();
+        }
+        bool drained;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            collectors[index].busy = false;
+            drained = queue.empty();
+        }
+        if (drained) {
+            uint64_t one = 1;
+            ssize_t written = write(doneFd, &one, sizeof(one));
+            (void)written;
+        }
+    }
+}
+
+void CollectorScheduler::closeFds() {
+    for (auto& collector : collectors) {
+        if (collector.timerFd >= 0) {
+            close(collector.timerFd);
+            collector.timerFd = -1;
+        }
+    }
+    if (epollFd >= 0) close(epollFd);
+    if (stopFd >= 0) close(stopFd);
+    if (doneFd >= 0) close(doneFd);
+    epollFd = -1;
+    stopFd = -1;
+    doneFd = -1;
+}
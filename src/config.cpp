@@ -12,6 +12,37 @@ void Config::setDefaultValues() {
     settings["memory_threshold"] = "80.0";
     settings["disk_threshold"] = "90.0";
     settings["gpu_temp_threshold"] = "80.0";
+    settings["process_scan_threads"] = "1";
+    settings["process_event_mode"] = "false";
+    settings["process_collector"] = "procfs";
+    settings["process_delta_max_bytes"] = "8388608";
+    settings["expanded_pids"] = "";
+    settings["disk_capacity_interval_ms"] = "10000";
+    settings["disk_stat_timeout_ms"] = "500";
+    settings["disk_io_util_threshold"] = "90.0";
+    settings["disk_io_latency_threshold_ms"] = "100.0";
+    settings["psi_cpu_trigger"] = "some 400000 2000000";
+    settings["psi_memory_trigger"] = "some 150000 2000000";
+    settings["psi_io_trigger"] = "full 200000 2000000";
+    settings["packet_capture_enabled"] = "false";
+    settings["packet_capture_interface"] = "";
+    settings["packet_ring_mb"] = "64";
+    settings["packet_snaplen"] = "128";
+    settings["cpu_interval_ms"] = "1000";
+    settings["memory_interval_ms"] = "1000";
+    settings["disk_interval_ms"] = "2000";
+    settings["gpu_interval_ms"] = "2000";
+    settings["network_interval_ms"] = "1000";
+    settings["battery_interval_ms"] = "30000";
+    settings["uptime_interval_ms"] = "1000";
+    settings["pressure_interval_ms"] = "2000";
+    settings["cgroups_interval_ms"] = "2000";
+    settings["connections_interval_ms"] = "2000";
+    settings["packet_flow_interval_ms"] = "1000";
+    settings["collector_threads"] = "2";
+    settings["record_interval_ms"] = "1000";
+    settings["history_memory_mb"] = "16";
+    settings["history_retention_s"] = "3600";
 }
 
 bool Config::load(const std::string& filename) {
@@ -58,6 +89,19 @@ T Config::getValue(const std::string& key, T defaultValue) const {
     return value;
 }
 
+template<>
+bool Config::getValue<bool>(const std::string& key, bool defaultValue) const {
+    auto it = settings.find(key);
+    if (it == settings.end()) {
+        return defaultValue;
+    }
+
+    std::string value;
+    std::istringstream iss(it->second);
+    iss >> value;
+    return value == "true" || value == "1" || value == "yes" || value == "on";
+}
+
 int Config::getUpdateIntervalMs() const {
     return getValue<int>("update_interval_ms", 2000);
 }
@@ -78,6 +122,100 @@ double Config::getGpuTempThreshold() const {
     return getValue<double>("gpu_temp_threshold", 80.0);
 }
 
+int Config::getProcessScanThreads() const {
+    return getValue<int>("process_scan_threads", 1);
+}
+
+bool Config::getProcessEventMode() const {
+    return getValue<bool>("process_event_mode", false);
+}
+
+std::string Config::getProcessCollector() const {
+    return getValue<std::string>("process_collector", "procfs");
+}
+
+size_t Config::getProcessDeltaMaxBytes() const {
+    return getValue<size_t>("process_delta_max_bytes", 8388608);
+}
+
+std::vector<int> Config::getExpandedPids() const {
+    std::vector<int> pids;
+    auto it = settings.find("expanded_pids");
+    if (it == settings.end()) {
+        return pids;
+    }
+
+    std::istringstream iss(it->second);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        std::istringstream itemStream(item);
+        int pid;
+        if (itemStream >> pid && pid > 0) {
+            pids.push_back(pid);
+        }
+    }
+    return pids;
+}
+
+int Config::getDiskCapacityIntervalMs() const {
+    return getValue<int>("disk_capacity_interval_ms", 10000);
+}
+
+int Config::getDiskStatTimeoutMs() const {
+    return getValue<int>("disk_stat_timeout_ms", 500);
+}
+
+double Config::getDiskIOUtilThreshold() const {
+    return getValue<double>("disk_io_util_threshold", 90.0);
+}
+
+double Config::getDiskIOLatencyThresholdMs() const {
+    return getValue<double>("disk_io_latency_threshold_ms", 100.0);
+}
+
+std::string Config::getPressureTrigger(const std::string& resource) const {
+    // read whole: getValue would stop at the first space
+    auto it = settings.find("psi_" + resource + "_trigger");
+    return it == settings.end() ? std::string() : it->second;
+}
+
+bool Config::getPacketCaptureEnabled() const {
+    return getValue<bool>("packet_capture_enabled", false);
+}
+
+std::string Config::getPacketCaptureInterface() const {
+    auto it = settings.find("packet_capture_interface");
+    return it == settings.end() ? std::string() : it->second;
+}
+
+int Config::getPacketRingMb() const {
+    return getValue<int>("packet_ring_mb", 64);
+}
+
+int Config::getPacketSnaplen() const {
+    return getValue<int>("packet_snaplen", 128);
+}
+
+int Config::getCollectorIntervalMs(const std::string& collector) const {
+    return getValue<int>(collector + "_interval_ms", getUpdateIntervalMs());
+}
+
+int Config::getCollectorThreads() const {
+    return getValue<int>("collector_threads", 2);
+}
+
+int Config::getRecordIntervalMs() const {
+    return getValue<int>("record_interval_ms", 1000);
+}
+
+int Config::getHistoryMemoryMb() const {
+    return getValue<int>("history_memory_mb", 16);
+}
+
+int Config::getHistoryRetentionSeconds() const {
+    return getValue<int>("history_retention_s", 3600);
+}
+
 void Config::setUpdateIntervalMs(int interval) {
     settings["update_interval_ms"] = std::to_string(interval);
 }
@@ -96,4 +234,87 @@ void Config::setDiskThreshold(double threshold) {
 
 void Config::setGpuTempThreshold(double threshold) {
     settings["gpu_temp_threshold"] = std::to_string(threshold);
+}
+
+void Config::setProcessScanThreads(int threads) {
+    settings["process_scan_threads"] = std::to_string(threads);
+}
+
+void Config::setProcessEventMode(bool enabled) {
+    settings["process_event_mode"] = enabled ? "true" : "false";
+}
+
+void Config::setProcessCollector(const std::string& collector) {
+    settings["process_collector"] = collector;
+}
+
+void Config::setProcessDeltaMaxBytes(size_t bytes) {
+    settings["process_delta_max_bytes"] = std::to_string(bytes);
+}
+
+void Config::setExpandedPids(const std::vector<int>& pids) {
+    std::string value;
+    for (int pid : pids) {
+        if (!value.empty()) {
+            value += ",";
+        }
+        value += std::to_string(pid);
+    }
+    settings["expanded_pids"] = value;
+}
+
+void Config::setDiskCapacityIntervalMs(int interval) {
+    settings["disk_capacity_interval_ms"] = std::to_string(interval);
+}
+
+void Config::setDiskStatTimeoutMs(int timeout) {
+    settings["disk_stat_timeout_ms"] = std::to_string(timeout);
+}
+
+void Config::setDiskIOUtilThreshold(double threshold) {
+    settings["disk_io_util_threshold"] = std::to_string(threshold);
+}
+
+void Config::setDiskIOLatencyThresholdMs(double threshold) {
+    settings["disk_io_latency_threshold_ms"] = std::to_string(threshold);
+}
+
+void Config::setPressureTrigger(const std::string& resource, const std::string& trigger) {
+    settings["psi_" + resource + "_trigger"] = trigger;
+}
+
+void Config::setPacketCaptureEnabled(bool enabled) {
+    settings["packet_capture_enabled"] = enabled ? "true" : "false";
+}
+
+void Config::setPacketCaptureInterface(const std::string& interface) {
+    settings["packet_capture_interface"] = interface;
+}
+
+void Config::setPacketRingMb(int megabytes) {
+    settings["packet_ring_mb"] = std::to_string(megabytes);
+}
+
+void Config::setPacketSnaplen(int bytes) {
+    settings["packet_snaplen"] = std::to_string(bytes);
+}
+
+void Config::setCollectorIntervalMs(const std::string& collector, int interval) {
+    settings[collector + "_interval_ms"] = std::to_string(interval);
+}
+
+void Config::setCollectorThreads(int threads) {
+    settings["collector_threads"] = std::to_string(threads);
+}
+
+void Config::setRecordIntervalMs(int interval) {
+    settings["record_interval_ms"] = std::to_string(interval);
+}
+
+void Config::setHistoryMemoryMb(int megabytes) {
+    settings["history_memory_mb"] = std::to_string(megabytes);
+}
+
+void Config::setHistoryRetentionSeconds(int seconds) {
+    settings["history_retention_s"] = std::to_string(seconds);
 }
\ No newline at end of file
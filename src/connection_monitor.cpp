@@ -0,0 +1,151 @@
+#include "../include/connection_monitor.h"
+#include <algorithm>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+namespace {
+
+std::string formatEndpoint(int family, const uint32_t* address, uint16_t port) {
+    char text[INET6_ADDRSTRLEN];
+    if (!inet_ntop(family, address, text, sizeof(text))) {
+        return "?";
+    }
+    std::string result = family == AF_INET6 ? "[" + std::string(text) + "]" : std::string(text);
+    return result + ":" + std::to_string(ntohs(port));
+}
+
+}
+
+ConnectionMonitor::ConnectionMonitor() {
+    if (!diagSocket.open(NETLINK_SOCK_DIAG, 0, error)) {
+        error = "sock_diag " + error;
+    }
+}
+
+bool ConnectionMonitor::update() {
+    if (!diagSocket.isOpen()) {
+        return false;
+    }
+    connections.clear();
+    sockets.clear();
+    auto handle = [this](const struct inet_diag_msg& message, const void* attributes, size_t length) {
+        handleSocket(message, attributes, length);
+    };
+    if (!dumpInetSockets(diagSocket, IPPROTO_TCP, 1 << (INET_DIAG_INFO - 1), requestBuffer, receiveBuffer,
+                         handle, error)) {
+        return false;
+    }
+
+    ownerIndex.update(sockets);
+    for (auto& connection : connections) {
+        connection.pid = ownerIndex.ownerOf(connection.inode);
+    }
+    summarize();
+    return true;
+}
+
+const std::vector<TcpConnection>& ConnectionMonitor::getConnections() const {
+    return connections;
+}
+
+const std::vector<ProcessConnections>& ConnectionMonitor::getProcesses() const {
+    return processes;
+}
+
+const std::string& ConnectionMonitor::getError() const {
+    return error;
+}
+
+unsigned long long ConnectionMonitor::fdLinksRead() const {
+    return ownerIndex.fdLinksRead();
+}
+
+void ConnectionMonitor::handleSocket(const struct inet_diag_msg& message, const void* attributes, size_t length) {
+    TcpConnection connection = {};
+    connection.local = formatEndpoint(message.idiag_family, message.id.idiag_src, message.id.idiag_sport);
+    connection.remote = formatEndpoint(message.idiag_family, message.id.idiag_dst, message.id.idiag_dport);
+    connection.state = message.idiag_state;
+    connection.inode = message.idiag_inode;
+    connection.uid = message.idiag_uid;
+    connection.sendQueue = message.idiag_wqueue;
+    connection.receiveQueue = message.idiag_rqueue;
+
+    forEachNetlinkAttribute(attributes, length, [&](uint16_t type, const char* data, size_t dataLength) {
+        if (type != INET_DIAG_INFO) {
+            return;
+        }
+        // tcp_info grows with every few kernel releases; take whatever prefix both sides know
+        struct tcp_info info = {};
+        memcpy(&info, data, std::min(dataLength, sizeof(info)));
+        connection.rttMs = info.tcpi_rtt / 1000.0;
+        connection.rttVarianceMs = info.tcpi_rttvar / 1000.0;
+        connection.congestionWindow = info.tcpi_snd_cwnd;
+        connection.retransmits = info.tcpi_total_retrans;
+        connection.hasInfo = true;
+    });
+
+    if (connection.inode != 0) {
+        sockets.push_back({connection.inode, connection.uid});
+    }
+    connections.push_back(std::move(connection));
+}
+
+void ConnectionMonitor::summarize() {
+    processes.clear();
+    std::unordered_map<int, size_t> slots;
+    for (size_t i = 0; i < connections.size(); ++i) {
+        const auto& connection = connections[i];
+        auto inserted = slots.try_emplace(connection.pid, processes.size());
+        if (inserted.second) {
+            ProcessConnections summary = {};
+            summary.pid = connection.pid;
+            summary.name = ownerIndex.processName(connection.pid);
+            processes.push_back(std::move(summary));
+        }
+        auto& summary = processes[inserted.first->second];
+        summary.members.push_back(static_cast<uint32_t>(i));
+        if (connection.state == TCP_LISTEN) {
+            ++summary.listening;
+            continue;
+        }
+        ++summary.connections;
+        summary.retransmits += connection.retransmits;
+        summary.sendQueue += connection.sendQueue;
+        summary.receiveQueue += connection.receiveQueue;
+        summary.averageRttMs += connection.rttMs;
+        summary.maxRttMs = std::max(summary.maxRttMs, connection.rttMs);
+    }
+
+    for (auto& summary : processes) {
+        if (summary.connections > 0) {
+            summary.averageRttMs /= static_cast<double>(summary.connections);
+        }
+        std::sort(summary.members.begin(), summary.members.end(), [this](uint32_t a, uint32_t b) {
+            return connections[a].rttMs > connections[b].rttMs;
+        });
+    }
+    std::sort(processes.begin(), processes.end(), [](const ProcessConnections& a, const ProcessConnections& b) {
+        if (a.connections != b.connections) return a.connections > b.connections;
+        return a.retransmits > b.retransmits;
+    });
+}
+
+const char* ConnectionMonitor::stateName(unsigned char state) {
+    switch (state) {
+        case TCP_ESTABLISHED: return "ESTAB";
+        case TCP_SYN_SENT: return "SYN-SENT";
+        case TCP_SYN_RECV: return "SYN-RECV";
+        case TCP_FIN_WAIT1: return "FIN-WAIT-1";
+        case TCP_FIN_WAIT2: return "FIN-WAIT-2";
+        case TCP_TIME_WAIT: return "TIME-WAIT";
+        case TCP_CLOSE: return "CLOSE";
+        case TCP_CLOSE_WAIT: return "CLOSE-WAIT";
+        case TCP_LAST_ACK: return "LAST-ACK";
+        case TCP_LISTEN: return "LISTEN";
+        case TCP_CLOSING: return "CLOSING";
+        default: return "?";
+    }
+}
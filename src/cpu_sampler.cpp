@@ -0,0 +1,114 @@
+#include "../include/cpu_sampler.h"
+#include "../include/proc_io.h"
+#include "../include/proc_parsers.h"
+
+CpuSampler::CpuSampler() : fd(openProcFile("/proc/stat")), lastAggregate{}, aggregateBreakdown{} {
+    aggregateBreakdown.online = true;
+}
+
+CpuSampler::~CpuSampler() {
+    closeProcFile(fd);
+}
+
+bool CpuSampler::sample() {
+    if (fd < 0) {
+        fd = openProcFile("/proc/stat");
+        if (fd < 0) {
+            return false;
+        }
+    }
+    auto content = readProcFile(fd, buffer);
+    if (!content) {
+        return false;
+    }
+
+    for (auto& core : coreBreakdowns) {
+        core.online = false;
+    }
+
+    std::string_view rest = *content;
+    while (!rest.empty()) {
+        std::string_view line = nextLine(rest);
+        std::string_view name = nextToken(line);
+        // the cpu lines come first; stop before the long intr/softirq lines
+        if (name.compare(0, 3, "cpu") != 0) {
+            break;
+        }
+
+        // steal arrived in 2.6.11; fields an older kernel doesn't report stay at zero
+        CpuTimes current = {};
+        size_t parsed = 0;
+        while (parsed < FIELD_COUNT && parseUnsigned(line, current.fields[parsed])) {
+            ++parsed;
+        }
+        if (parsed < 4) {
+            continue;
+        }
+        current.valid = true;
+
+        if (name.size() == 3) {
+            computeBreakdown(lastAggregate, current, aggregateBreakdown);
+            lastAggregate = current;
+            continue;
+        }
+
+        int index;
+        if (!parsePid(name.substr(3), index)) {
+            continue;
+        }
+        size_t core = static_cast<size_t>(index);
+        if (core >= lastCores.size()) {
+            lastCores.resize(core + 1, CpuTimes{});
+            coreBreakdowns.resize(core + 1, CpuBreakdown{});
+        }
+        computeBreakdown(lastCores[core], current, coreBreakdowns[core]);
+        coreBreakdowns[core].online = true;
+        lastCores[core] = current;
+    }
+
+    for (size_t core = 0; core < coreBreakdowns.size(); ++core) {
+        if (!coreBreakdowns[core].online) {
+            coreBreakdowns[core] = CpuBreakdown{};
+            lastCores[core].valid = false;
+        }
+    }
+    return true;
+}
+
+const CpuBreakdown& CpuSampler::aggregate() const {
+    return aggregateBreakdown;
+}
+
+const std::vector<CpuBreakdown>& CpuSampler::cores() const {
+    return coreBreakdowns;
+}
+
+void CpuSampler::computeBreakdown(const CpuTimes& last, const CpuTimes& current, CpuBreakdown& breakdown) {
+    if (!last.valid) {
+        return;
+    }
+
+    // guest time is already folded into user and nice, so it is not added again
+    double deltas[FIELD_COUNT];
+    double total = 0;
+    for (size_t i = 0; i < FIELD_COUNT; ++i) {
+        // iowait can step backwards on some kernels; treat that as no time spent
+        unsigned long long before = last.fields[i];
+        unsigned long long after = current.fields[i];
+        deltas[i] = after > before ? static_cast<double>(after - before) : 0.0;
+        total += deltas[i];
+    }
+    if (total <= 0) {
+        return;
+    }
+
+    breakdown.user = 100.0 * deltas[0] / total;
+    breakdown.nice = 100.0 * deltas[1] / total;
+    breakdown.system = 100.0 * deltas[2] / total;
+    breakdown.idle = 100.0 * deltas[3] / total;
+    breakdown.iowait = 100.0 * deltas[4] / total;
+    breakdown.irq = 100.0 * deltas[5] / total;
+    breakdown.softirq = 100.0 * deltas[6] / total;
+    breakdown.steal = 100.0 * deltas[7] / total;
+    breakdown.utilization = 100.0 - breakdown.idle - breakdown.iowait;
+}
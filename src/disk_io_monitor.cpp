@@ -0,0 +1,161 @@
+#include "../include/disk_io_monitor.h"
+#include "../include/proc_io.h"
+#include "../include/proc_parsers.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+// /proc/diskstats counts in 512-byte sectors whatever the device's block size
+constexpr double SECTOR_BYTES = 512.0;
+
+bool isIgnoredDevice(std::string_view name) {
+    return name.compare(0, 3, "ram") == 0 || name.compare(0, 4, "loop") == 0;
+}
+
+// counters restart from zero when a device is removed and re-added under the same number
+unsigned long long delta(unsigned long long before, unsigned long long after) {
+    return after > before ? after - before : 0;
+}
+
+double rate(unsigned long long before, unsigned long long after, double seconds) {
+    return static_cast<double>(delta(before, after)) / seconds;
+}
+
+}
+
+DiskIOMonitor::DiskIOMonitor() : fd(openProcFile("/proc/diskstats")), hasSample(false) {}
+
+DiskIOMonitor::~DiskIOMonitor() {
+    closeProcFile(fd);
+}
+
+bool DiskIOMonitor::update() {
+    if (fd < 0) {
+        fd = openProcFile("/proc/diskstats");
+        if (fd < 0) {
+            return false;
+        }
+    }
+    auto content = readProcFile(fd, buffer);
+    if (!content) {
+        return false;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - lastSample).count();
+    double elapsedMs = seconds * 1000.0;
+    bool haveInterval = hasSample && seconds > 0;
+    std::fill(seen.begin(), seen.end(), 0);
+
+    std::string_view rest = *content;
+    while (!rest.empty()) {
+        std::string_view line = nextLine(rest);
+        unsigned long long major, minor;
+        if (!parseUnsigned(line, major) || !parseUnsigned(line, minor)) {
+            continue;
+        }
+        std::string_view name = nextToken(line);
+
+        // fields 4-14; discard and flush counters that newer kernels append are not used
+        unsigned long long fields[11];
+        size_t parsed = 0;
+        while (parsed < 11 && parseUnsigned(line, fields[parsed])) {
+            ++parsed;
+        }
+        if (parsed < 11 || isIgnoredDevice(name) || fields[0] + fields[4] == 0) {
+            continue;
+        }
+        Counters current = {fields[0], fields[2], fields[3], fields[4], fields[6], fields[7],
+                            fields[8], fields[9], fields[10]};
+
+        uint64_t key = (major << 32) | minor;
+        auto slot = slots.find(key);
+        bool fresh = slot == slots.end();
+        size_t index = fresh ? addDevice(key, name) : slot->second;
+        seen[index] = 1;
+
+        auto& stats = devices[index];
+        const auto& last = lastCounters[index];
+        stats.inFlight = current.inFlight;
+        if (!fresh && haveInterval) {
+            unsigned long long reads = delta(last.reads, current.reads);
+            unsigned long long writes = delta(last.writes, current.writes);
+            stats.readIops = static_cast<double>(reads) / seconds;
+            stats.writeIops = static_cast<double>(writes) / seconds;
+            stats.readBytesPerSec = rate(last.readSectors, current.readSectors, seconds) * SECTOR_BYTES;
+            stats.writeBytesPerSec = rate(last.writeSectors, current.writeSectors, seconds) * SECTOR_BYTES;
+            stats.readLatencyMs = reads ? static_cast<double>(delta(last.readMs, current.readMs)) / static_cast<double>(reads) : 0.0;
+            stats.writeLatencyMs = writes ? static_cast<double>(delta(last.writeMs, current.writeMs)) / static_cast<double>(writes) : 0.0;
+            stats.queueDepth = rate(last.weightedMs, current.weightedMs, elapsedMs);
+            stats.utilization = std::min(100.0, 100.0 * rate(last.ioMs, current.ioMs, elapsedMs));
+        }
+        lastCounters[index] = current;
+    }
+
+    if (std::find(seen.begin(), seen.end(), 0) != seen.end()) {
+        dropUnseen();
+    }
+    lastSample = now;
+    hasSample = true;
+    return true;
+}
+
+const std::vector<DiskIOStats>& DiskIOMonitor::getDevices() const {
+    return devices;
+}
+
+size_t DiskIOMonitor::addDevice(uint64_t key, std::string_view name) {
+    DiskIOStats stats = {};
+    stats.name = std::string(name);
+    stats.label = stats.name;
+
+    // sysfs spells the '/' in names like cciss/c0d0 as '!'
+    std::string sysfsName = stats.name;
+    std::replace(sysfsName.begin(), sysfsName.end(), '/', '!');
+    const std::string sysfsPath = "/sys/class/block/" + sysfsName;
+    std::error_code ec;
+    if (std::filesystem::exists(sysfsPath + "/partition", ec)) {
+        // a partition's sysfs directory sits inside its disk's
+        auto device = std::filesystem::canonical(sysfsPath, ec);
+        if (!ec) {
+            stats.parent = device.parent_path().filename().string();
+            std::replace(stats.parent.begin(), stats.parent.end(), '!', '/');
+        }
+    }
+    std::ifstream dmName(sysfsPath + "/dm/name");
+    std::string mapped;
+    if (std::getline(dmName, mapped) && !mapped.empty()) {
+        stats.label = mapped;
+    }
+
+    devices.push_back(std::move(stats));
+    lastCounters.push_back(Counters{});
+    keys.push_back(key);
+    seen.push_back(0);
+    slots.emplace(key, devices.size() - 1);
+    return devices.size() - 1;
+}
+
+void DiskIOMonitor::dropUnseen() {
+    // a device went away; compact and rebuild the index, which only happens on hot-unplug
+    size_t kept = 0;
+    for (size_t i = 0; i < devices.size(); ++i) {
+        if (seen[i]) {
+            devices[kept] = std::move(devices[i]);
+            lastCounters[kept] = lastCounters[i];
+            keys[kept] = keys[i];
+            ++kept;
+        }
+    }
+    devices.resize(kept);
+    lastCounters.resize(kept);
+    keys.resize(kept);
+    seen.assign(kept, 1);
+
+    slots.clear();
+    for (size_t i = 0; i < kept; ++i) {
+        slots.emplace(keys[i], i);
+    }
+}
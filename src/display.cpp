@@ -4,11 +4,20 @@
 #include <algorithm>
 #include <chrono>
 #include <ctime>
+#include <netinet/tcp.h>
 
-Display::Display() : mainWindow(nullptr), cpuWindow(nullptr), memoryWindow(nullptr), diskWindow(nullptr),
+Display::Display(SelfStats& stats) : mainWindow(nullptr), cpuWindow(nullptr), memoryWindow(nullptr), diskWindow(nullptr),
                      logWindow(nullptr), processWindow(nullptr), networkWindow(nullptr), 
                      batteryWindow(nullptr), gpuWindow(nullptr), timeWindow(nullptr),
-                     processListScrollPosition(0), needsUpdate(false) {
+                     processListScrollPosition(0), selectedPid(0), expandedPidsChanged(false),
+                     listView(ListView::Processes), cgroupScrollPosition(0), connectionScrollPosition(0),
+                     selfStatsScrollPosition(0), selfStats(stats),
+                     timePanelStat(stats.get("panel time")), cpuPanelStat(stats.get("panel cpu")),
+                     memoryPanelStat(stats.get("panel memory")), diskPanelStat(stats.get("panel disk")),
+                     processPanelStat(stats.get("panel processes")), cgroupPanelStat(stats.get("panel cgroups")),
+                     connectionPanelStat(stats.get("panel connections")), selfStatsPanelStat(stats.get("panel self-stats")),
+                     networkPanelStat(stats.get("panel network")), logPanelStat(stats.get("panel log")),
+                     gpuPanelStat(stats.get("panel gpu")), batteryPanelStat(stats.get("panel battery")), needsUpdate(false) {
     initializeScreen();
 }
 
@@ -32,6 +41,8 @@ void Display::initializeScreen() {
     noecho();
     keypad(stdscr, TRUE);
     nodelay(stdscr, TRUE);
+    // the event loop reads keys when stdin is readable; don't poll for typeahead on every line drawn
+    typeahead(-1);
     curs_set(0);
     start_color();
     use_default_colors();
@@ -79,30 +90,52 @@ void Display::update(const SystemMonitor& monitor) {
     updateGPUInfo(monitor.getGPUInfo());
     updateMemoryWindow(monitor);
     updateDiskWindow(monitor);
-    updateProcessWindow(monitor.getProcesses());
+    updateListWindow(monitor);
     updateNetworkInfo(monitor.getNetworkInterfaces());
     updateBatteryInfo(monitor);
     updateLogWindow();
 }
 
 void Display::updateTimeInfo(const SystemMonitor& monitor) {
-    wclear(timeWindow);
+    SelfStatScope scope(timePanelStat);
+    werase(timeWindow);
     mvwprintw(timeWindow, 0, (COLS - 40) / 2, "Current Time: %s | Uptime: %s", 
               getCurrentTime().c_str(), formatUptime(monitor.getUptime()).c_str());
     wrefresh(timeWindow);
 }
 
 void Display::updateCPUWindow(const SystemMonitor& monitor) {
-    wclear(cpuWindow);
+    SelfStatScope scope(cpuPanelStat);
+    werase(cpuWindow);
     box(cpuWindow, 0, 0);
-    mvwprintw(cpuWindow, 0, 2, "CPU");
+    mvwprintw(cpuWindow, 0, 2, "CPU%s", formatTrend(monitor.getHistory(), "cpu").c_str());
     mvwprintw(cpuWindow, 1, 2, "Model: %s", monitor.getCpuModel().c_str());
     mvwprintw(cpuWindow, 2, 2, "Overall Usage: %.2f%%", monitor.getCpuUsage());
-    drawBarGraph(cpuWindow, 3, 2, 20, monitor.getCpuUsage());
+    int column = 27;
+    for (const auto& sensor : monitor.getTemperatureSensors()) {
+        if (sensor.kind == SensorKind::Package && sensor.valid) {
+            mvwprintw(cpuWindow, 2, column, "%s: %.1f°C", sensor.label.c_str(), sensor.celsius);
+            column += static_cast<int>(sensor.label.size()) + 11;
+        }
+    }
+    const auto& breakdown = monitor.getCpuBreakdown();
+    mvwprintw(cpuWindow, 3, 2, "us %.1f sy %.1f ni %.1f wa %.1f hi %.1f si %.1f st %.1f",
+              breakdown.user, breakdown.system, breakdown.nice, breakdown.iowait,
+              breakdown.irq, breakdown.softirq, breakdown.steal);
+    drawBarGraph(cpuWindow, 4, 2, 20, monitor.getCpuUsage());
+    const auto& cpuPressure = monitor.getPressure(PressureResource::Cpu);
+    if (cpuPressure.available) {
+        mvwprintw(cpuWindow, 4, 26, "PSI %s", formatPressure(cpuPressure).c_str());
+    }
 
     const auto& coreInfo = monitor.getCPUCoreInfo();
-    int row = 4;
+    int row = 5;
     for (size_t i = 0; i < coreInfo.size(); ++i) {
+        if (!coreInfo[i].breakdown.online) {
+            mvwprintw(cpuWindow, row, 2, "Core %zu: offline", i);
+            row += 2;
+            continue;
+        }
         mvwprintw(cpuWindow, row, 2, "Core %zu: %.2f%% (%.1f°C) %.2f GHz", 
                   i, coreInfo[i].utilization, coreInfo[i].temperature, coreInfo[i].clockSpeed);
         drawBarGraph(cpuWindow, row + 1, 2, 20, coreInfo[i].utilization);
@@ -112,54 +145,236 @@ void Display::updateCPUWindow(const SystemMonitor& monitor) {
 }
 
 void Display::updateMemoryWindow(const SystemMonitor& monitor) {
-    wclear(memoryWindow);
+    SelfStatScope scope(memoryPanelStat);
+    werase(memoryWindow);
     box(memoryWindow, 0, 0);
-    mvwprintw(memoryWindow, 0, 2, "Memory");
+    mvwprintw(memoryWindow, 0, 2, "Memory%s", formatTrend(monitor.getHistory(), "memory").c_str());
     double totalMemoryGB = monitor.getTotalMemory() / (1024.0 * 1024 * 1024);
-    mvwprintw(memoryWindow, 1, 2, "Total: %.2f GB", totalMemoryGB);
+    const auto& memory = monitor.getMemoryInfo();
+    mvwprintw(memoryWindow, 1, 2, "Total: %.2f GB  Available: %.2f GB", totalMemoryGB, memory.available() / (1024.0 * 1024));
     mvwprintw(memoryWindow, 2, 2, "Usage: %.2f%%", monitor.getMemoryUsage());
+    const auto& memoryPressure = monitor.getPressure(PressureResource::Memory);
+    if (memoryPressure.available) {
+        mvwprintw(memoryWindow, 2, 18, "PSI %s", formatPressure(memoryPressure).c_str());
+    }
     drawBarGraph(memoryWindow, 3, 2, 20, monitor.getMemoryUsage());
+
+    // breakdown lines only where the window has room above its bottom border
+    int lastRow = getmaxy(memoryWindow) - 2;
+    if (lastRow >= 4) {
+        mvwprintw(memoryWindow, 4, 2, "Swap: %.2f/%.2f GB  Dirty: %.1f MB  Writeback: %.1f MB",
+                  (memory.swapTotal - memory.swapFree) / (1024.0 * 1024), memory.swapTotal / (1024.0 * 1024),
+                  memory.dirty / 1024.0, memory.writeback / 1024.0);
+    }
+    if (lastRow >= 5) {
+        mvwprintw(memoryWindow, 5, 2, "Slab: %.1f MB  Shmem: %.1f MB  AnonHuge: %.1f MB  HugePages: %llu/%llu",
+                  memory.slab / 1024.0, memory.shmem / 1024.0, memory.anonHugePages / 1024.0,
+                  memory.hugePagesTotal - memory.hugePagesFree, memory.hugePagesTotal);
+    }
     wrefresh(memoryWindow);
 }
 
 void Display::updateDiskWindow(const SystemMonitor& monitor) {
-    wclear(diskWindow);
+    SelfStatScope scope(diskPanelStat);
+    werase(diskWindow);
     box(diskWindow, 0, 0);
     mvwprintw(diskWindow, 0, 2, "Disk");
+    int column = 7;
+    for (const auto& sensor : monitor.getTemperatureSensors()) {
+        if (sensor.kind == SensorKind::Nvme && sensor.valid) {
+            mvwprintw(diskWindow, 0, column, " %s %.0f°C ", sensor.label.c_str(), sensor.celsius);
+            column += static_cast<int>(sensor.label.size()) + 9;
+        }
+    }
     const auto& partitions = monitor.getDiskPartitions();
     for (size_t i = 0; i < partitions.size() && i < 4; ++i) {
         const auto& part = partitions[i];
         double totalGB = part.totalSpace / (1024.0 * 1024 * 1024);
         double usedGB = part.usedSpace / (1024.0 * 1024 * 1024);
-        double usagePercent = (static_cast<double>(part.usedSpace) / part.totalSpace) * 100.0;
-        mvwprintw(diskWindow, 1 + i * 2, 2, "%s (%s): %.1f/%.1f GB (%.2f%%)", 
-                  part.name.c_str(), part.mountPoint.c_str(), usedGB, totalGB, usagePercent);
+        double usagePercent = part.totalSpace > 0 ? (static_cast<double>(part.usedSpace) / part.totalSpace) * 100.0 : 0.0;
+        mvwprintw(diskWindow, 1 + i * 2, 2, "%s (%s): %.1f/%.1f GB (%.2f%%)%s", 
+                  part.name.c_str(), part.mountPoint.c_str(), usedGB, totalGB, usagePercent,
+                  part.stale ? " not responding" : "");
         drawBarGraph(diskWindow, 2 + i * 2, 2, 20, usagePercent);
     }
+
+    // whole-disk I/O below the partitions, busiest first, as far down as the window reaches
+    int row = 1 + static_cast<int>(std::min<size_t>(partitions.size(), 4)) * 2;
+    int lastRow = getmaxy(diskWindow) - 2;
+    const auto& ioPressure = monitor.getPressure(PressureResource::Io);
+    if (ioPressure.available && row <= lastRow) {
+        mvwprintw(diskWindow, row++, 2, "PSI %s", formatPressure(ioPressure).c_str());
+    }
+    std::vector<const DiskIOStats*> disks;
+    for (const auto& device : monitor.getDiskIOStats()) {
+        if (device.parent.empty()) {
+            disks.push_back(&device);
+        }
+    }
+    std::sort(disks.begin(), disks.end(),
+              [](const DiskIOStats* a, const DiskIOStats* b) { return a->utilization > b->utilization; });
+    for (const DiskIOStats* disk : disks) {
+        if (row > lastRow) {
+            break;
+        }
+        mvwprintw(diskWindow, row++, 2, "%-8.8s r %4.0f/s %5.1fMB/s %4.1fms  w %4.0f/s %5.1fMB/s %4.1fms  q%.1f %3.0f%%",
+                  disk->label.c_str(), disk->readIops, disk->readBytesPerSec / (1024.0 * 1024),
+                  disk->readLatencyMs, disk->writeIops, disk->writeBytesPerSec / (1024.0 * 1024),
+                  disk->writeLatencyMs, disk->queueDepth, disk->utilization);
+    }
     wrefresh(diskWindow);
 }
 
-void Display::updateProcessWindow(const std::vector<ProcessInfo>& processes) {
-    wclear(processWindow);
+void Display::updateProcessWindow(const ProcessSnapshot& processes) {
+    SelfStatScope scope(processPanelStat);
+    werase(processWindow);
     box(processWindow, 0, 0);
-    mvwprintw(processWindow, 0, 2, "Process List (Use UP/DOWN to scroll)");
+    mvwprintw(processWindow, 0, 2, "Process List (UP/DOWN to scroll, t for threads)");
     int maxRows, maxCols;
     getmaxyx(processWindow, maxRows, maxCols);
     int displayableRows = maxRows - 2;  // Subtract 2 for the box borders
 
     size_t startIndex = processListScrollPosition;
-    size_t endIndex = std::min(startIndex + displayableRows, processes.size());
+    selectedPid = startIndex < processes.size() ? processes.ranked(startIndex).pid : 0;
+
+    int row = 1;
+    for (size_t i = startIndex; i < processes.size() && row <= displayableRows; ++i) {
+        ProcessInfo process = processes.ranked(i);
+        std::string_view name = processes.name(process);
+        if (i == startIndex) {
+            wattron(processWindow, A_REVERSE);
+        }
+        mvwprintw(processWindow, row, 1, "%-20.*s CPU: %5.1f%% Mem: %5.1f MB",
+                  static_cast<int>(name.size()), name.data(), process.cpuUsage, process.memoryUsage);
+        if (processes.table.hasNetwork) {
+            wprintw(processWindow, " Net: %7.1f/%7.1f KB/s", process.networkReceive / 1024.0,
+                    process.networkSend / 1024.0);
+        }
+        ++row;
+        if (i == startIndex) {
+            wattroff(processWindow, A_REVERSE);
+        }
+
+        const ThreadGroup* group = processes.threadsOf(process.pid);
+        for (uint32_t t = 0; group && t < group->count && row <= displayableRows; ++t) {
+            const ThreadInfo& thread = processes.threads[group->first + t];
+            std::string_view threadName = processes.names->get(thread.nameId);
+            mvwprintw(processWindow, row++, 1, "  %-18.*s CPU: %5.1f%% %c tid %d",
+                      static_cast<int>(threadName.size()), threadName.data(), thread.cpuUsage, thread.state, thread.tid);
+        }
+    }
+    wrefresh(processWindow);
+}
+
+void Display::updateListWindow(const SystemMonitor& monitor) {
+    switch (listView) {
+        case ListView::Cgroups:
+            updateCgroupWindow(monitor);
+            break;
+        case ListView::Connections:
+            updateConnectionWindow(monitor);
+            break;
+        case ListView::SelfStats:
+            updateSelfStatsWindow();
+            break;
+        case ListView::Processes:
+            publishExpandedPids(monitor);
+            updateProcessWindow(*monitor.getProcesses(visibleProcessRows()));
+            break;
+    }
+}
+
+void Display::updateCgroupWindow(const SystemMonitor& monitor) {
+    SelfStatScope scope(cgroupPanelStat);
+    werase(processWindow);
+    box(processWindow, 0, 0);
+    mvwprintw(processWindow, 0, 2, "Cgroups: %zu (UP/DOWN to scroll, c for processes)", monitor.getCgroupCount());
+    int maxRows, maxCols;
+    getmaxyx(processWindow, maxRows, maxCols);
+    int displayableRows = maxRows - 2;
+
+    const auto& cgroups = monitor.getCgroups(visibleCgroupRows());
+    if (cgroups.empty()) {
+        mvwprintw(processWindow, 1, 1, "No cgroup v2 hierarchy");
+    }
+    int row = 1;
+    for (size_t i = cgroupScrollPosition; i < cgroups.size() && row <= displayableRows; ++i) {
+        const auto& cgroup = cgroups[i];
+        // the tail of the path is the part that tells services and containers apart
+        std::string_view path = cgroup.path;
+        if (path.size() > 28) {
+            path = path.substr(path.size() - 28);
+        }
+        mvwprintw(processWindow, row++, 1, "%-28.*s CPU:%6.1f%% thr:%5.1f%% Mem:%8.1f MB IO r/w:%6.1f/%6.1f MB/s pids:%llu",
+                  static_cast<int>(path.size()), path.data(), cgroup.cpuUsage, cgroup.throttledPercent,
+                  cgroup.memoryCurrent / (1024.0 * 1024), cgroup.ioReadBytesPerSec / (1024.0 * 1024),
+                  cgroup.ioWriteBytesPerSec / (1024.0 * 1024), cgroup.pids);
+    }
+    wrefresh(processWindow);
+}
+
+void Display::updateConnectionWindow(const SystemMonitor& monitor) {
+    SelfStatScope scope(connectionPanelStat);
+    werase(processWindow);
+    box(processWindow, 0, 0);
+    const auto& connections = monitor.getConnections();
+    mvwprintw(processWindow, 0, 2, "TCP: %zu sockets (UP/DOWN to scroll, n for processes)", connections.size());
+    int displayableRows = getmaxy(processWindow) - 2;
 
-    for (size_t i = startIndex; i < endIndex; ++i) {
+    // each process is followed by its connections, slowest round trip first
+    const auto& processes = monitor.getConnectionsByProcess();
+    int row = 1;
+    for (size_t i = connectionScrollPosition; i < processes.size() && row <= displayableRows; ++i) {
         const auto& process = processes[i];
-        mvwprintw(processWindow, i - startIndex + 1, 1, "%-20s CPU: %5.1f%% Mem: %5.1f MB",
-                  process.name.c_str(), process.cpuUsage, process.memoryUsage);
+        wattron(processWindow, A_BOLD);
+        mvwprintw(processWindow, row++, 1, "%-16.16s %6d conn:%4zu listen:%3zu rtt avg/max:%6.1f/%6.1f ms retr:%llu q s/r:%llu/%llu",
+                  process.name.c_str(), process.pid, process.connections, process.listening,
+                  process.averageRttMs, process.maxRttMs, process.retransmits, process.sendQueue, process.receiveQueue);
+        wattroff(processWindow, A_BOLD);
+        for (uint32_t index : process.members) {
+            if (row > displayableRows) {
+                break;
+            }
+            const auto& connection = connections[index];
+            if (connection.hasInfo && connection.state != TCP_LISTEN) {
+                mvwprintw(processWindow, row++, 1, "  %-10s %-22.22s > %-22.22s rtt %6.1f±%.1f ms cwnd %u retr %u q %llu/%llu",
+                          ConnectionMonitor::stateName(connection.state), connection.local.c_str(), connection.remote.c_str(),
+                          connection.rttMs, connection.rttVarianceMs, connection.congestionWindow, connection.retransmits,
+                          connection.sendQueue, connection.receiveQueue);
+            } else {
+                mvwprintw(processWindow, row++, 1, "  %-10s %-22.22s",
+                          ConnectionMonitor::stateName(connection.state), connection.local.c_str());
+            }
+        }
+    }
+    wrefresh(processWindow);
+}
+
+void Display::updateSelfStatsWindow() {
+    SelfStatScope scope(selfStatsPanelStat);
+    werase(processWindow);
+    box(processWindow, 0, 0);
+    mvwprintw(processWindow, 0, 2, "Monitor overhead (UP/DOWN to scroll, s for processes)");
+    int maxRows, maxCols;
+    getmaxyx(processWindow, maxRows, maxCols);
+
+    // the header stays put; the entries scroll under it
+    std::istringstream report(selfStats.report());
+    std::string line;
+    std::getline(report, line);
+    mvwaddnstr(processWindow, 1, 1, line.c_str(), maxCols - 2);
+    int row = 2;
+    for (size_t i = 0; std::getline(report, line) && row < maxRows - 1; ++i) {
+        if (i >= selfStatsScrollPosition) {
+            mvwaddnstr(processWindow, row++, 1, line.c_str(), maxCols - 2);
+        }
     }
     wrefresh(processWindow);
 }
 
 void Display::updateNetworkInfo(const std::vector<NetworkInterface>& interfaces) {
-    wclear(networkWindow);
+    SelfStatScope scope(networkPanelStat);
+    werase(networkWindow);
     box(networkWindow, 0, 0);
     mvwprintw(networkWindow, 0, 2, "Network Information");
     int row = 1;
@@ -175,6 +390,9 @@ void Display::updateNetworkInfo(const std::vector<NetworkInterface>& interfaces)
         mvwprintw(networkWindow, row++, 1, "Up: %.2f MB/s (Total: %s)", 
                   interface.uploadSpeed / (1024 * 1024),
                   formatBytes(interface.totalBytesSent).c_str());
+        mvwprintw(networkWindow, row++, 1, "Pkts: %.0f/%.0f/s Err: %llu/%llu Drop: %llu/%llu",
+                  interface.packetsReceivedPerSec, interface.packetsSentPerSec,
+                  interface.receiveErrors, interface.sendErrors, interface.receiveDropped, interface.sendDropped);
         row++;
 
         maxDownloadSpeed = std::max(maxDownloadSpeed, interface.downloadSpeed);
@@ -188,7 +406,8 @@ void Display::updateNetworkInfo(const std::vector<NetworkInterface>& interfaces)
 }
 
 void Display::updateLogWindow() {
-    wclear(logWindow);
+    SelfStatScope scope(logPanelStat);
+    werase(logWindow);
     box(logWindow, 0, 0);
     mvwprintw(logWindow, 0, 2, "Log Messages");
     size_t startIndex = logMessages.size() > MAX_LOG_MESSAGES ? logMessages.size() - MAX_LOG_MESSAGES : 0;
@@ -199,7 +418,8 @@ void Display::updateLogWindow() {
 }
 
 void Display::updateGPUInfo(const std::vector<GPUInfo>& gpuInfos) {
-    wclear(gpuWindow);
+    SelfStatScope scope(gpuPanelStat);
+    werase(gpuWindow);
     box(gpuWindow, 0, 0);
     mvwprintw(gpuWindow, 0, 2, "GPU");
     for (size_t i = 0; i < gpuInfos.size() && i < 2; ++i) {
@@ -213,7 +433,8 @@ void Display::updateGPUInfo(const std::vector<GPUInfo>& gpuInfos) {
 }
 
 void Display::updateBatteryInfo(const SystemMonitor& monitor) {
-    wclear(batteryWindow);
+    SelfStatScope scope(batteryPanelStat);
+    werase(batteryWindow);
     box(batteryWindow, 0, 0);
     mvwprintw(batteryWindow, 0, 2, "Battery");
     const auto& battery = monitor.getBatteryMonitor();
@@ -223,14 +444,54 @@ void Display::updateBatteryInfo(const SystemMonitor& monitor) {
     wrefresh(batteryWindow);
 }
 
+size_t Display::visibleProcessRows() const {
+    int maxRows = getmaxy(processWindow);
+    return processListScrollPosition + static_cast<size_t>(std::max(maxRows - 2, 0));
+}
+
+size_t Display::visibleCgroupRows() const {
+    int maxRows = getmaxy(processWindow);
+    return cgroupScrollPosition + static_cast<size_t>(std::max(maxRows - 2, 0));
+}
+
 void Display::scrollProcessList(int direction) {
-    processListScrollPosition += direction;
-    if (processListScrollPosition < 0) {
-        processListScrollPosition = 0;
+    size_t& position = listView == ListView::Cgroups ? cgroupScrollPosition
+                     : listView == ListView::Connections ? connectionScrollPosition
+                     : listView == ListView::SelfStats ? selfStatsScrollPosition
+                     : processListScrollPosition;
+    if (direction < 0 && position == 0) {
+        return;
+    }
+    position += direction;
+    needsUpdate = true;
+}
+
+void Display::toggleThreadView() {
+    if (selectedPid <= 0) {
+        return;
     }
+    auto it = std::find(expandedPids.begin(), expandedPids.end(), selectedPid);
+    if (it != expandedPids.end()) {
+        expandedPids.erase(it);
+    } else {
+        expandedPids.push_back(selectedPid);
+    }
+    expandedPidsChanged = true;
+    needsUpdate = true;
+}
+
+void Display::toggleListView(ListView view) {
+    listView = listView == view ? ListView::Processes : view;
     needsUpdate = true;
 }
 
+void Display::publishExpandedPids(const SystemMonitor& monitor) {
+    if (expandedPidsChanged) {
+        monitor.setExpandedPids(expandedPids);
+        expandedPidsChanged = false;
+    }
+}
+
 void Display::showAlert(const std::string& message) {
     addLogMessage("ALERT: " + message);
 }
@@ -245,25 +506,47 @@ void Display::addLogMessage(const std::string& message) {
 }
 
 bool Display::handleInput() {
-    int ch = wgetch(stdscr);
-    switch (ch) {
-        case 'q':
-        case 'Q':
-            return false;
-        case KEY_UP:
-            scrollProcessList(-1);
-            return true;
-        case KEY_DOWN:
-            scrollProcessList(1);
-            return true;
-        default:
-            return true;
+    // drains every key waiting, so the caller only needs to be woken once per burst of input
+    int ch;
+    while ((ch = wgetch(stdscr)) != ERR) {
+        switch (ch) {
+            case 'q':
+            case 'Q':
+                return false;
+            case KEY_UP:
+                scrollProcessList(-1);
+                break;
+            case KEY_DOWN:
+                scrollProcessList(1);
+                break;
+            case 't':
+            case 'T':
+                if (listView == ListView::Processes) {
+                    toggleThreadView();
+                }
+                break;
+            case 'c':
+            case 'C':
+                toggleListView(ListView::Cgroups);
+                break;
+            case 'n':
+            case 'N':
+                toggleListView(ListView::Connections);
+                break;
+            case 's':
+            case 'S':
+                toggleListView(ListView::SelfStats);
+                break;
+            default:
+                break;
+        }
     }
+    return true;
 }
 
 void Display::forceUpdate(const SystemMonitor& monitor) {
     if (needsUpdate) {
-        updateProcessWindow(monitor.getProcesses());
+        updateListWindow(monitor);
         needsUpdate = false;
     }
 }
@@ -279,6 +562,29 @@ std::string Display::formatUptime(long uptime) const {
     return oss.str();
 }
 
+// avg10/avg60/avg300 stall percentages
+std::string Display::formatPressure(const ResourcePressure& pressure) const {
+    char text[96];
+    int length = snprintf(text, sizeof(text), "some %.2f/%.2f/%.2f",
+                          pressure.some.avg10, pressure.some.avg60, pressure.some.avg300);
+    if (pressure.hasFull && length > 0 && static_cast<size_t>(length) < sizeof(text)) {
+        snprintf(text + length, sizeof(text) - length, " full %.2f/%.2f/%.2f",
+                 pressure.full.avg10, pressure.full.avg60, pressure.full.avg300);
+    }
+    return text;
+}
+
+// last minute of a percentage series, for a panel title; empty until there is history
+std::string Display::formatTrend(const MetricHistory& history, const std::string& series) const {
+    WindowStats stats;
+    if (!history.recent(history.find(series), 60000, stats) || stats.samples < 2) {
+        return "";
+    }
+    char text[64];
+    snprintf(text, sizeof(text), " 1m avg %.1f%% p95 %.1f%% max %.1f%%", stats.avg, stats.p95, stats.max);
+    return text;
+}
+
 std::string Display::getCurrentTime() const {
     auto now = std::chrono::system_clock::now();
     auto time = std::chrono::system_clock::to_time_t(now);
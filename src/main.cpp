@@ -3,18 +3,22 @@
 #include "../include/display.h"
 #include "../include/config.h"
 #include "../include/logger.h"
+#include "../include/self_stats.h"
+#include "../include/metric_writer.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
 
-int main() {
-    Config config;
-    if (!config.load("system_monitor.conf")) {
-        std::cout << "Failed to load configuration. Using default values.\n";
-    }
-
-    auto logger = std::make_shared<Logger>("system_monitor.log");
+namespace {
 
-    Display display;
-    SystemMonitor monitor(config, logger, display, true); 
+int runMonitor(const Config& config, std::shared_ptr<Logger> logger, SelfStats& selfStats) {
+    Display display(selfStats);
+    SystemMonitor monitor(config, logger, &display, true, selfStats);
 
     if (!monitor.initialize()) {
         std::cerr << "Failed to initialize system monitor" << std::endl;
@@ -23,7 +27,7 @@ int main() {
 
     logger->logInfo("System Monitor started");
     display.addLogMessage("System Monitor started.");
-    display.addLogMessage("Use 'q' to quit the app and UP/DOWN arrows to scroll");
+    display.addLogMessage("Use 'q' to quit the app, UP/DOWN arrows to scroll, 't' to show threads, 'c' for cgroups, 'n' for TCP connections and 's' for the monitor's own overhead");
 
 
     try {
@@ -36,6 +40,101 @@ int main() {
 
     logger->logInfo("System Monitor stopped");
     display.addLogMessage("System Monitor stopped");
+    return 0;
+}
+
+int runHeadless(const Config& config, std::shared_ptr<Logger> logger, SelfStats& selfStats, MetricWriter& records) {
+    // blocked before any thread exists so every thread inherits it and run() takes them from a signalfd
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &signals, nullptr);
+    // a reader going away shows up as EPIPE from write()
+    signal(SIGPIPE, SIG_IGN);
+
+    SystemMonitor monitor(config, logger, nullptr, true, selfStats);
+    if (!monitor.initialize()) {
+        std::cerr << "Failed to initialize system monitor" << std::endl;
+        return 1;
+    }
 
+    logger->logInfo("System Monitor started headless");
+    try {
+        monitor.run(&records);
+    } catch (const std::exception& e) {
+        logger->logError("Unexpected error: " + std::string(e.what()));
+        std::cerr << "An unexpected error occurred: " << e.what() << std::endl;
+        return 1;
+    }
+    logger->logInfo("System Monitor stopped");
+    if (!records.getError().empty()) {
+        std::cerr << records.getError() << std::endl;
+        return 1;
+    }
     return 0;
-}
\ No newline at end of file
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    bool dumpSelfStats = false;
+    bool headless = false;
+    RecordFormat format = RecordFormat::Line;
+    std::string outputPath;
+    int intervalMs = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--self-stats") {
+            dumpSelfStats = true;
+        } else if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--format" && hasValue && MetricWriter::parseFormat(argv[i + 1], format)) {
+            ++i;
+        } else if (arg == "--output" && hasValue) {
+            outputPath = argv[++i];
+        } else if (arg == "--interval" && hasValue && (intervalMs = std::atoi(argv[i + 1])) > 0) {
+            ++i;
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--self-stats] [--headless [--format line|json] [--output PATH] [--interval MS]]" << std::endl;
+            return 1;
+        }
+    }
+
+    Config config;
+    if (!config.load("system_monitor.conf")) {
+        // stdout may be the record stream
+        std::cerr << "Failed to load configuration. Using default values.\n";
+    }
+    if (intervalMs > 0) {
+        config.setRecordIntervalMs(intervalMs);
+    }
+
+    auto logger = std::make_shared<Logger>("system_monitor.log");
+    SelfStats selfStats;
+    int status;
+    if (headless) {
+        int fd = STDOUT_FILENO;
+        if (!outputPath.empty()) {
+            fd = open(outputPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (fd < 0) {
+                std::cerr << "Cannot open " << outputPath << ": " << strerror(errno) << std::endl;
+                return 1;
+            }
+        }
+        MetricWriter records(format, fd);
+        status = runHeadless(config, logger, selfStats, records);
+        if (fd != STDOUT_FILENO) {
+            close(fd);
+        }
+    } else {
+        // the display is gone by the time runMonitor returns, so the report lands on a normal terminal
+        status = runMonitor(config, logger, selfStats);
+    }
+    if (dumpSelfStats) {
+        (headless ? std::cerr : std::cout) << selfStats.report();
+    }
+    return status;
+}
@@ -0,0 +1,129 @@
+#include "../include/memory_sampler.h"
+#include "../include/proc_io.h"
+#include "../include/proc_parsers.h"
+#include <string_view>
+
+namespace {
+
+struct MemoryKey {
+    std::string_view name;
+    unsigned long long MemoryInfo::*field;
+};
+
+constexpr MemoryKey MEMORY_KEYS[] = {
+    {"MemTotal:", &MemoryInfo::memTotal},
+    {"MemFree:", &MemoryInfo::memFree},
+    {"MemAvailable:", &MemoryInfo::memAvailable},
+    {"Buffers:", &MemoryInfo::buffers},
+    {"Cached:", &MemoryInfo::cached},
+    {"SwapCached:", &MemoryInfo::swapCached},
+    {"SwapTotal:", &MemoryInfo::swapTotal},
+    {"SwapFree:", &MemoryInfo::swapFree},
+    {"Dirty:", &MemoryInfo::dirty},
+    {"Writeback:", &MemoryInfo::writeback},
+    {"Shmem:", &MemoryInfo::shmem},
+    {"Slab:", &MemoryInfo::slab},
+    {"SReclaimable:", &MemoryInfo::sReclaimable},
+    {"SUnreclaim:", &MemoryInfo::sUnreclaim},
+    {"AnonHugePages:", &MemoryInfo::anonHugePages},
+    {"HugePages_Total:", &MemoryInfo::hugePagesTotal},
+    {"HugePages_Free:", &MemoryInfo::hugePagesFree},
+    {"Hugepagesize:", &MemoryInfo::hugePageSize},
+};
+constexpr int MEMORY_KEY_COUNT = static_cast<int>(sizeof(MEMORY_KEYS) / sizeof(MEMORY_KEYS[0]));
+constexpr int MEM_AVAILABLE_SLOT = 2;
+
+int findSlot(std::string_view key) {
+    for (int slot = 0; slot < MEMORY_KEY_COUNT; ++slot) {
+        if (MEMORY_KEYS[slot].name == key) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+}
+
+unsigned long long MemoryInfo::available() const {
+    if (hasMemAvailable) {
+        return memAvailable;
+    }
+    unsigned long long estimate = memFree + buffers + cached;
+    return estimate < memTotal ? estimate : memTotal;
+}
+
+double MemoryInfo::usedPercent() const {
+    if (memTotal == 0) {
+        return 0.0;
+    }
+    return 100.0 * static_cast<double>(memTotal - available()) / static_cast<double>(memTotal);
+}
+
+MemorySampler::MemorySampler() : fd(openProcFile("/proc/meminfo")), current{}, total(0) {
+    // the process monitor reads totalKb() from its own thread, possibly before the first tick
+    sample();
+}
+
+MemorySampler::~MemorySampler() {
+    closeProcFile(fd);
+}
+
+bool MemorySampler::sample() {
+    if (fd < 0) {
+        fd = openProcFile("/proc/meminfo");
+        if (fd < 0) {
+            return false;
+        }
+    }
+    auto content = readProcFile(fd, buffer);
+    if (!content) {
+        return false;
+    }
+
+    MemoryInfo next = {};
+    std::string_view rest = *content;
+    for (size_t line = 0; !rest.empty(); ++line) {
+        std::string_view text = nextLine(rest);
+        std::string_view key = nextToken(text);
+        if (line >= lineSlots.size()) {
+            lineSlots.push_back(static_cast<int8_t>(findSlot(key)));
+        }
+
+        // the set of lines is fixed for the running kernel, so untracked lines are skipped
+        // unchecked and a tracked one only needs its key confirmed
+        int slot = lineSlots[line];
+        if (slot < 0) {
+            continue;
+        }
+        if (MEMORY_KEYS[slot].name != key) {
+            slot = findSlot(key);
+            lineSlots[line] = static_cast<int8_t>(slot);
+            if (slot < 0) {
+                continue;
+            }
+        }
+
+        unsigned long long value;
+        if (parseUnsigned(text, value)) {
+            next.*(MEMORY_KEYS[slot].field) = value;
+            if (slot == MEM_AVAILABLE_SLOT) {
+                next.hasMemAvailable = true;
+            }
+        }
+    }
+    if (next.memTotal == 0) {
+        return false;
+    }
+
+    current = next;
+    total.store(current.memTotal, std::memory_order_relaxed);
+    return true;
+}
+
+const MemoryInfo& MemorySampler::info() const {
+    return current;
+}
+
+unsigned long long MemorySampler::totalKb() const {
+    return total.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,298 @@
+#include "../include/metric_history.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const int64_t ROLLUP_RESOLUTIONS_MS[] = {10000, 60000};
+// below this a raw ring is not worth keeping
+constexpr size_t MIN_RAW_CAPACITY = 16;
+// an hour at 1 s; faster series keep less raw and lean on the rollups, so one 10 ms series
+// cannot take the budget from a hundred 1 s ones
+constexpr size_t MAX_RAW_CAPACITY = 4096;
+
+}
+
+MetricHistory::MetricHistory(size_t budgetBytes, int retentionSeconds)
+    : budgetBytes(budgetBytes), retentionMs(std::max<int64_t>(retentionSeconds, 1) * 1000), used(0) {}
+
+MetricHistory::SeriesId MetricHistory::series(const std::string& name, int intervalMs) {
+    auto it = byName.find(name);
+    if (it != byName.end()) {
+        return it->second;
+    }
+
+    int64_t interval = std::max(intervalMs, 1);
+    std::vector<size_t> rollupCapacities;
+    size_t rollupBytes = 0;
+    for (int64_t resolution : ROLLUP_RESOLUTIONS_MS) {
+        if (interval < resolution) {
+            // one extra bucket so the oldest one is still whole at the retention edge
+            size_t capacity = static_cast<size_t>(retentionMs / resolution) + 1;
+            rollupCapacities.push_back(capacity);
+            rollupBytes += tierBytes(capacity, true);
+        }
+    }
+    size_t rawCapacity = static_cast<size_t>(retentionMs / interval) + 1;
+    rawCapacity = std::max(std::min(rawCapacity, MAX_RAW_CAPACITY), MIN_RAW_CAPACITY);
+
+    // a retired series of the same shape hands its rings over as they are
+    for (size_t i = 0; i < retired.size(); ++i) {
+        Series& candidate = allSeries[retired[i]];
+        if (candidate.tiers.size() != rollupCapacities.size() + 1 || candidate.tiers[0].capacity != rawCapacity) {
+            continue;
+        }
+        bool sameShape = true;
+        for (size_t t = 0; t < rollupCapacities.size(); ++t) {
+            sameShape = sameShape && candidate.tiers[t + 1].capacity == rollupCapacities[t];
+        }
+        if (!sameShape) {
+            continue;
+        }
+        for (auto& tier : candidate.tiers) {
+            tier.head = 0;
+            tier.size = 0;
+            tier.bucketCount = 0;
+        }
+        SeriesId id = retired[i];
+        retired.erase(retired.begin() + static_cast<std::ptrdiff_t>(i));
+        candidate.name = name;
+        candidate.live = true;
+        byName.emplace(name, id);
+        return id;
+    }
+
+    while (rollupBytes + tierBytes(rawCapacity, false) > budgetBytes - used && releaseRetired()) {
+    }
+    size_t remaining = budgetBytes - used;
+    if (rollupBytes + tierBytes(MIN_RAW_CAPACITY, false) > remaining) {
+        return NO_SERIES;
+    }
+    rawCapacity = std::min(rawCapacity, (remaining - rollupBytes) / tierBytes(1, false));
+
+    Series created;
+    created.name = name;
+    created.live = true;
+    auto addTier = [&created](int64_t resolution, size_t capacity, bool rollup) {
+        Tier tier = {};
+        tier.resolutionMs = resolution;
+        tier.capacity = capacity;
+        tier.timestamps.resize(capacity);
+        tier.values.resize(capacity);
+        if (rollup) {
+            tier.minimums.resize(capacity);
+            tier.maximums.resize(capacity);
+        }
+        created.tiers.push_back(std::move(tier));
+    };
+    addTier(0, rawCapacity, false);
+    for (size_t i = 0; i < rollupCapacities.size(); ++i) {
+        addTier(ROLLUP_RESOLUTIONS_MS[i], rollupCapacities[i], true);
+    }
+    used += seriesBytes(created);
+
+    // ids of retired series whose rings were freed are reused before the table grows
+    SeriesId id = static_cast<SeriesId>(allSeries.size());
+    auto freed = std::find_if(retired.begin(), retired.end(), [this](SeriesId r) { return allSeries[r].tiers.empty(); });
+    if (freed != retired.end()) {
+        id = *freed;
+        retired.erase(freed);
+        allSeries[id] = std::move(created);
+    } else {
+        allSeries.push_back(std::move(created));
+    }
+    byName.emplace(name, id);
+    return id;
+}
+
+void MetricHistory::retire(SeriesId id) {
+    if (!isLive(id)) {
+        return;
+    }
+    Series& series = allSeries[id];
+    byName.erase(series.name);
+    series.name.clear();
+    series.live = false;
+    retired.push_back(id);
+}
+
+bool MetricHistory::releaseRetired() {
+    for (SeriesId id : retired) {
+        Series& series = allSeries[id];
+        if (!series.tiers.empty()) {
+            used -= seriesBytes(series);
+            std::vector<Tier>().swap(series.tiers);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MetricHistory::isLive(SeriesId id) const {
+    return id < allSeries.size() && allSeries[id].live;
+}
+
+MetricHistory::SeriesId MetricHistory::find(const std::string& name) const {
+    auto it = byName.find(name);
+    return it == byName.end() ? NO_SERIES : it->second;
+}
+
+void MetricHistory::append(SeriesId id, int64_t timestampMs, float value) {
+    if (!isLive(id)) {
+        return;
+    }
+    auto& tiers = allSeries[id].tiers;
+    push(tiers[0], timestampMs, value, value, value);
+    for (size_t i = 1; i < tiers.size(); ++i) {
+        Tier& tier = tiers[i];
+        int64_t bucket = timestampMs - timestampMs % tier.resolutionMs;
+        if (tier.bucketCount > 0 && bucket != tier.bucketStart) {
+            flushBucket(tier);
+        }
+        if (tier.bucketCount == 0) {
+            tier.bucketStart = bucket;
+            tier.bucketMin = value;
+            tier.bucketMax = value;
+            tier.bucketSum = 0;
+        }
+        tier.bucketMin = std::min(tier.bucketMin, value);
+        tier.bucketMax = std::max(tier.bucketMax, value);
+        tier.bucketSum += value;
+        ++tier.bucketCount;
+    }
+}
+
+bool MetricHistory::query(SeriesId id, int64_t fromMs, int64_t toMs, WindowStats& stats) const {
+    if (!isLive(id) || fromMs > toMs) {
+        return false;
+    }
+    // the finest tier that has not yet dropped anything from the window, else the coarsest
+    const auto& tiers = allSeries[id].tiers;
+    const Tier* tier = &tiers.back();
+    for (const auto& candidate : tiers) {
+        if (candidate.size < candidate.capacity || oldest(candidate) <= fromMs) {
+            tier = &candidate;
+            break;
+        }
+    }
+
+    static thread_local std::vector<float> window;
+    window.clear();
+    size_t begin = lowerBound(*tier, fromMs);
+    size_t count = lowerBound(*tier, toMs + 1) - begin;
+    size_t start = count == 0 ? 0 : slot(*tier, begin);
+    // the window is at most two contiguous runs of each column
+    size_t firstRun = std::min(count, tier->capacity - start);
+    const float* values = tier->values.data();
+    window.insert(window.end(), values + start, values + start + firstRun);
+    window.insert(window.end(), values, values + (count - firstRun));
+
+    float minimum = std::numeric_limits<float>::infinity();
+    float maximum = -std::numeric_limits<float>::infinity();
+    const float* minimums = tier->resolutionMs == 0 ? values : tier->minimums.data();
+    const float* maximums = tier->resolutionMs == 0 ? values : tier->maximums.data();
+    for (size_t i = start; i < start + firstRun; ++i) {
+        minimum = std::min(minimum, minimums[i]);
+        maximum = std::max(maximum, maximums[i]);
+    }
+    for (size_t i = 0; i < count - firstRun; ++i) {
+        minimum = std::min(minimum, minimums[i]);
+        maximum = std::max(maximum, maximums[i]);
+    }
+    // a rollup's current bucket is not in the ring yet
+    if (tier->resolutionMs != 0 && tier->bucketCount > 0 && tier->bucketStart >= fromMs && tier->bucketStart <= toMs) {
+        window.push_back(static_cast<float>(tier->bucketSum / static_cast<double>(tier->bucketCount)));
+        minimum = std::min(minimum, tier->bucketMin);
+        maximum = std::max(maximum, tier->bucketMax);
+    }
+    if (window.empty()) {
+        return false;
+    }
+
+    double sum = 0;
+    for (float value : window) {
+        sum += value;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(0.95 * static_cast<double>(window.size()))) - 1;
+    std::nth_element(window.begin(), window.begin() + static_cast<std::ptrdiff_t>(rank), window.end());
+
+    stats.samples = window.size();
+    stats.min = minimum;
+    stats.max = maximum;
+    stats.avg = static_cast<float>(sum / static_cast<double>(window.size()));
+    stats.p95 = window[rank];
+    stats.resolutionMs = tier->resolutionMs;
+    return true;
+}
+
+bool MetricHistory::recent(SeriesId id, int64_t spanMs, WindowStats& stats) const {
+    if (!isLive(id)) {
+        return false;
+    }
+    const Tier& raw = allSeries[id].tiers[0];
+    if (raw.size == 0) {
+        return false;
+    }
+    int64_t newest = raw.timestamps[slot(raw, raw.size - 1)];
+    return query(id, newest - spanMs, newest, stats);
+}
+
+size_t MetricHistory::bytesUsed() const {
+    return used;
+}
+
+size_t MetricHistory::budget() const {
+    return budgetBytes;
+}
+
+size_t MetricHistory::tierBytes(size_t capacity, bool rollup) {
+    return capacity * (sizeof(int64_t) + sizeof(float) * (rollup ? 3 : 1));
+}
+
+size_t MetricHistory::seriesBytes(const Series& series) {
+    size_t bytes = 0;
+    for (const auto& tier : series.tiers) {
+        bytes += tierBytes(tier.capacity, tier.resolutionMs != 0);
+    }
+    return bytes;
+}
+
+void MetricHistory::push(Tier& tier, int64_t timestampMs, float value, float minimum, float maximum) {
+    tier.timestamps[tier.head] = timestampMs;
+    tier.values[tier.head] = value;
+    if (!tier.minimums.empty()) {
+        tier.minimums[tier.head] = minimum;
+        tier.maximums[tier.head] = maximum;
+    }
+    tier.head = tier.head + 1 == tier.capacity ? 0 : tier.head + 1;
+    tier.size = std::min(tier.size + 1, tier.capacity);
+}
+
+void MetricHistory::flushBucket(Tier& tier) {
+    push(tier, tier.bucketStart, static_cast<float>(tier.bucketSum / static_cast<double>(tier.bucketCount)),
+         tier.bucketMin, tier.bucketMax);
+    tier.bucketCount = 0;
+}
+
+size_t MetricHistory::slot(const Tier& tier, size_t index) {
+    size_t physical = tier.head + tier.capacity - tier.size + index;
+    return physical >= tier.capacity ? physical - tier.capacity : physical;
+}
+
+size_t MetricHistory::lowerBound(const Tier& tier, int64_t timestampMs) {
+    size_t low = 0;
+    size_t high = tier.size;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (tier.timestamps[slot(tier, middle)] < timestampMs) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+int64_t MetricHistory::oldest(const Tier& tier) {
+    return tier.size == 0 ? std::numeric_limits<int64_t>::max() : tier.timestamps[slot(tier, 0)];
+}
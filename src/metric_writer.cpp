@@ -0,0 +1,331 @@
+#include "../include/metric_writer.h"
+#include "../include/system_monitor.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t INITIAL_BUFFER_SIZE = 64 * 1024;
+// longest number appendInteger or appendDecimal can produce
+constexpr size_t MAX_NUMBER_LENGTH = 32;
+
+const PressureResource PRESSURE_RESOURCES[] = {PressureResource::Cpu, PressureResource::Memory, PressureResource::Io};
+
+}
+
+MetricWriter::MetricWriter(RecordFormat format, int fd)
+    : format(format), fd(fd), buffer(INITIAL_BUFFER_SIZE), used(0), timestamp(0), listGroup(false), firstEntry(true),
+      firstField(true) {}
+
+bool MetricWriter::write(const SystemMonitor& monitor, unsigned long long timestampNs) {
+    if (!error.empty()) {
+        return false;
+    }
+    used = 0;
+    timestamp = timestampNs;
+    writeRecord(monitor);
+
+    size_t written = 0;
+    while (written < used) {
+        ssize_t n = ::write(fd, buffer.data() + written, used - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            error = std::string("writing records: ") + strerror(errno);
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+const std::string& MetricWriter::getError() const {
+    return error;
+}
+
+bool MetricWriter::parseFormat(const std::string& name, RecordFormat& format) {
+    if (name == "line") {
+        format = RecordFormat::Line;
+    } else if (name == "json") {
+        format = RecordFormat::Json;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void MetricWriter::writeRecord(const SystemMonitor& monitor) {
+    if (format == RecordFormat::Json) {
+        append("{\"timestamp\":");
+        appendInteger(timestamp);
+    }
+
+    beginGroup("system", false);
+    beginEntry();
+    field("cpu", monitor.getCpuUsage());
+    field("memory", monitor.getMemoryUsage());
+    field("disk", monitor.getDiskUsage());
+    integerField("uptime", static_cast<unsigned long long>(std::max(monitor.getUptime(), 0L)));
+    booleanField("alert", monitor.isAlertTriggered());
+    endEntry();
+    endGroup();
+
+    beginGroup("cpu", true);
+    const auto& cores = monitor.getCPUCoreInfo();
+    for (size_t i = 0; i < cores.size(); ++i) {
+        beginEntry();
+        tag("core", i);
+        field("usage", cores[i].utilization);
+        field("temperature", cores[i].temperature);
+        field("ghz", cores[i].clockSpeed);
+        endEntry();
+    }
+    endGroup();
+
+    const auto& memory = monitor.getMemoryInfo();
+    beginGroup("memory", false);
+    beginEntry();
+    integerField("total", memory.memTotal * 1024);
+    integerField("available", memory.available() * 1024);
+    integerField("swap_used", (memory.swapTotal - std::min(memory.swapFree, memory.swapTotal)) * 1024);
+    endEntry();
+    endGroup();
+
+    beginGroup("disk", true);
+    for (const auto& partition : monitor.getDiskPartitions()) {
+        beginEntry();
+        tag("mount", partition.mountPoint);
+        tag("device", partition.name);
+        integerField("total", partition.totalSpace);
+        integerField("used", partition.usedSpace);
+        endEntry();
+    }
+    endGroup();
+
+    beginGroup("diskio", true);
+    for (const auto& device : monitor.getDiskIOStats()) {
+        beginEntry();
+        tag("device", device.label);
+        field("read_bytes", device.readBytesPerSec);
+        field("write_bytes", device.writeBytesPerSec);
+        field("read_iops", device.readIops);
+        field("write_iops", device.writeIops);
+        field("read_latency_ms", device.readLatencyMs);
+        field("write_latency_ms", device.writeLatencyMs);
+        field("utilization", device.utilization);
+        endEntry();
+    }
+    endGroup();
+
+    beginGroup("net", true);
+    for (const auto& interface : monitor.getNetworkInterfaces()) {
+        beginEntry();
+        tag("interface", interface.name);
+        field("rx_bytes", interface.downloadSpeed);
+        field("tx_bytes", interface.uploadSpeed);
+        field("rx_packets", interface.packetsReceivedPerSec);
+        field("tx_packets", interface.packetsSentPerSec);
+        integerField("rx_errors", interface.receiveErrors);
+        integerField("tx_errors", interface.sendErrors);
+        integerField("rx_dropped", interface.receiveDropped);
+        integerField("tx_dropped", interface.sendDropped);
+        endEntry();
+    }
+    endGroup();
+
+    beginGroup("gpu", true);
+    for (const auto& gpu : monitor.getGPUInfo()) {
+        beginEntry();
+        tag("index", static_cast<unsigned long long>(std::max(gpu.index, 0)));
+        field("utilization", gpu.gpuUtilization);
+        field("memory_utilization", gpu.memoryUtilization);
+        field("temperature", gpu.temperature);
+        field("power", gpu.powerUsage);
+        endEntry();
+    }
+    endGroup();
+
+    beginGroup("pressure", true);
+    for (PressureResource resource : PRESSURE_RESOURCES) {
+        const auto& pressure = monitor.getPressure(resource);
+        if (!pressure.available) {
+            continue;
+        }
+        beginEntry();
+        tag("resource", PressureMonitor::resourceName(resource));
+        field("some_avg10", pressure.some.avg10);
+        if (pressure.hasFull) {
+            field("full_avg10", pressure.full.avg10);
+        }
+        endEntry();
+    }
+    endGroup();
+
+    if (format == RecordFormat::Json) {
+        append("}\n");
+    }
+}
+
+void MetricWriter::beginGroup(std::string_view name, bool list) {
+    measurement = name;
+    listGroup = list;
+    firstEntry = true;
+    if (format == RecordFormat::Json) {
+        append(",\"");
+        append(name);
+        append(list ? "\":[" : "\":");
+    }
+}
+
+void MetricWriter::endGroup() {
+    if (format == RecordFormat::Json && listGroup) {
+        append("]");
+    }
+}
+
+void MetricWriter::beginEntry() {
+    firstField = true;
+    if (format == RecordFormat::Json) {
+        append(firstEntry ? "{" : ",{");
+    } else {
+        append(measurement);
+    }
+    firstEntry = false;
+}
+
+void MetricWriter::endEntry() {
+    if (format == RecordFormat::Json) {
+        append("}");
+    } else {
+        append(" ");
+        appendInteger(timestamp);
+        append("\n");
+    }
+}
+
+void MetricWriter::tag(std::string_view key, std::string_view value) {
+    if (format == RecordFormat::Json) {
+        fieldKey(key);
+        appendJsonString(value);
+    } else {
+        append(",");
+        append(key);
+        append("=");
+        appendTag(value);
+    }
+}
+
+void MetricWriter::tag(std::string_view key, unsigned long long value) {
+    if (format == RecordFormat::Json) {
+        fieldKey(key);
+    } else {
+        append(",");
+        append(key);
+        append("=");
+    }
+    appendInteger(value);
+}
+
+void MetricWriter::field(std::string_view key, double value) {
+    fieldKey(key);
+    appendDecimal(value);
+}
+
+void MetricWriter::integerField(std::string_view key, unsigned long long value) {
+    fieldKey(key);
+    appendInteger(value);
+    if (format == RecordFormat::Line) {
+        append("i");
+    }
+}
+
+void MetricWriter::booleanField(std::string_view key, bool value) {
+    fieldKey(key);
+    append(value ? "true" : "false");
+}
+
+void MetricWriter::fieldKey(std::string_view key) {
+    if (format == RecordFormat::Json) {
+        append(firstField ? "\"" : ",\"");
+        append(key);
+        append("\":");
+    } else {
+        // tags come first; the space ends them
+        append(firstField ? " " : ",");
+        append(key);
+        append("=");
+    }
+    firstField = false;
+}
+
+char* MetricWriter::reserve(size_t length) {
+    if (used + length > buffer.size()) {
+        buffer.resize(std::max(buffer.size() * 2, used + length));
+    }
+    return buffer.data() + used;
+}
+
+void MetricWriter::append(std::string_view text) {
+    memcpy(reserve(text.size()), text.data(), text.size());
+    used += text.size();
+}
+
+void MetricWriter::appendInteger(unsigned long long value) {
+    char* out = reserve(MAX_NUMBER_LENGTH);
+    used = static_cast<size_t>(std::to_chars(out, out + MAX_NUMBER_LENGTH, value).ptr - buffer.data());
+}
+
+void MetricWriter::appendDecimal(double value) {
+    // neither format has a spelling for NaN or infinity
+    if (!std::isfinite(value)) {
+        value = 0;
+    }
+    char* out = reserve(MAX_NUMBER_LENGTH);
+    auto result = std::to_chars(out, out + MAX_NUMBER_LENGTH, value, std::chars_format::fixed, 2);
+    if (result.ec != std::errc()) {
+        result = std::to_chars(out, out + MAX_NUMBER_LENGTH, value, std::chars_format::scientific, 6);
+    }
+    used = static_cast<size_t>(result.ptr - buffer.data());
+}
+
+void MetricWriter::appendTag(std::string_view value) {
+    // an empty tag value is invalid in line protocol
+    if (value.empty()) {
+        append("-");
+        return;
+    }
+    char* out = reserve(value.size() * 2);
+    for (char c : value) {
+        if (c == ',' || c == ' ' || c == '=') {
+            *out++ = '\\';
+        }
+        *out++ = c;
+    }
+    used = static_cast<size_t>(out - buffer.data());
+}
+
+void MetricWriter::appendJsonString(std::string_view value) {
+    // worst case every byte becomes \u00XX
+    char* out = reserve(value.size() * 6 + 2);
+    *out++ = '"';
+    for (char c : value) {
+        auto byte = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            *out++ = '\\';
+            *out++ = c;
+        } else if (byte < 0x20) {
+            static const char hex[] = "0123456789abcdef";
+            memcpy(out, "\\u00", 4);
+            out[4] = hex[byte >> 4];
+            out[5] = hex[byte & 0xf];
+            out += 6;
+        } else {
+            *out++ = c;
+        }
+    }
+    *out++ = '"';
+    used = static_cast<size_t>(out - buffer.data());
+}
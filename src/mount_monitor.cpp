@@ -0,0 +1,240 @@
+#include "../include/mount_monitor.h"
+#include "../include/proc_io.h"
+#include "../include/proc_parsers.h"
+#include <algorithm>
+#include <poll.h>
+#include <system_error>
+#include <sys/statvfs.h>
+
+struct MountMonitor::Probe {
+    std::string mountPoint;
+    std::mutex mutex;
+    std::condition_variable done;
+    bool finished = false;
+    bool ok = false;
+    unsigned long long total = 0;
+    unsigned long long used = 0;
+};
+
+namespace {
+
+// /proc/mounts writes space, tab, newline and backslash in paths as \ooo
+std::string unescapeMountPath(std::string_view path) {
+    std::string result;
+    result.reserve(path.size());
+    for (size_t i = 0; i < path.size(); ++i) {
+        if (path[i] == '\\' && i + 3 < path.size() &&
+            path[i + 1] >= '0' && path[i + 1] <= '3' && path[i + 2] >= '0' && path[i + 2] <= '7' &&
+            path[i + 3] >= '0' && path[i + 3] <= '7') {
+            result += static_cast<char>((path[i + 1] - '0') * 64 + (path[i + 2] - '0') * 8 + (path[i + 3] - '0'));
+            i += 3;
+        } else {
+            result += path[i];
+        }
+    }
+    return result;
+}
+
+bool isListedMount(std::string_view device, std::string_view fsType) {
+    return device.compare(0, 5, "/dev/") == 0 && fsType != "tmpfs" && fsType != "devtmpfs";
+}
+
+}
+
+MountMonitor::MountMonitor(int capacityIntervalMs, int statTimeoutMs)
+    : mountsFd(openProcFile("/proc/self/mounts")),
+      capacityInterval(std::max(capacityIntervalMs, 100)), statTimeout(std::max(statTimeoutMs, 10)),
+      generation(0), copiedGeneration(0), mountsChanged(false), running(false) {
+    readMountTable();
+}
+
+MountMonitor::~MountMonitor() {
+    stop();
+    closeProcFile(mountsFd);
+}
+
+void MountMonitor::start() {
+    if (running) {
+        return;
+    }
+    running = true;
+    capacityThread = std::thread(&MountMonitor::runCapacityThread, this);
+}
+
+void MountMonitor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wake.notify_all();
+    if (capacityThread.joinable()) {
+        capacityThread.join();
+    }
+}
+
+void MountMonitor::update() {
+    if (mountsFd < 0) {
+        return;
+    }
+    // the kernel raises POLLPRI (with POLLERR) once per mount or umount in this namespace
+    struct pollfd pfd = {mountsFd, POLLPRI, 0};
+    if (poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLPRI | POLLERR))) {
+        readMountTable();
+        wake.notify_all();
+    }
+}
+
+bool MountMonitor::refreshPartitions(std::vector<DiskPartitionInfo>& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (generation == copiedGeneration) {
+        return false;
+    }
+    out.clear();
+    for (const auto& mount : mounts) {
+        // a mount whose first statvfs hung is still shown, as not responding
+        if (mount.listed && (mount.sampled || mount.info.stale)) {
+            out.push_back(mount.info);
+        }
+    }
+    copiedGeneration = generation;
+    return true;
+}
+
+std::optional<DiskPartitionInfo> MountMonitor::root() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& mount : mounts) {
+        if (mount.info.mountPoint == "/" && mount.sampled) {
+            return mount.info;
+        }
+    }
+    return std::nullopt;
+}
+
+void MountMonitor::readMountTable() {
+    // the table spans several seq_file pages on busy hosts; readProcFile starts over at offset 0
+    // and reads to the end, and a mount that lands mid-read raises POLLPRI again
+    auto content = readProcFile(mountsFd, buffer);
+    if (!content) {
+        return;
+    }
+
+    std::vector<Mount> next;
+    std::string_view rest = *content;
+    while (!rest.empty()) {
+        std::string_view line = nextLine(rest);
+        std::string_view device = nextToken(line);
+        std::string_view mountPoint = nextToken(line);
+        std::string_view fsType = nextToken(line);
+        if (fsType.empty()) {
+            continue;
+        }
+        bool listed = isListedMount(device, fsType);
+        if (!listed && mountPoint != "/") {
+            continue;
+        }
+
+        Mount mount = {};
+        mount.info.name = unescapeMountPath(listed ? device.substr(5) : device);
+        mount.info.mountPoint = unescapeMountPath(mountPoint);
+        mount.listed = listed;
+        // a later mount over the same point hides the earlier one
+        auto hidden = std::find_if(next.begin(), next.end(),
+                                   [&](const Mount& m) { return m.info.mountPoint == mount.info.mountPoint; });
+        if (hidden != next.end()) {
+            *hidden = std::move(mount);
+        } else {
+            next.push_back(std::move(mount));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& mount : next) {
+        for (auto& old : mounts) {
+            if (old.info.mountPoint == mount.info.mountPoint && old.info.name == mount.info.name) {
+                mount.info = old.info;
+                mount.sampled = old.sampled;
+                mount.pending = std::move(old.pending);
+                break;
+            }
+        }
+    }
+    mounts = std::move(next);
+    mountsChanged = true;
+    ++generation;
+}
+
+void MountMonitor::sampleCapacities() {
+    std::vector<std::pair<std::string, std::shared_ptr<Probe>>> targets;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        mountsChanged = false;
+        for (const auto& mount : mounts) {
+            targets.emplace_back(mount.info.mountPoint, mount.pending);
+        }
+    }
+
+    for (auto& [mountPoint, probe] : targets) {
+        if (!running) {
+            return;
+        }
+        bool finished;
+        if (probe) {
+            // a call that overran earlier is not repeated until it comes back
+            std::lock_guard<std::mutex> probeLock(probe->mutex);
+            finished = probe->finished;
+            if (!finished) {
+                continue;
+            }
+        } else {
+            // statvfs cannot be interrupted, so it runs on a thread that can be left behind
+            probe = std::make_shared<Probe>();
+            probe->mountPoint = mountPoint;
+            try {
+                std::thread([probe]() {
+                    struct statvfs stats;
+                    bool ok = statvfs(probe->mountPoint.c_str(), &stats) == 0;
+                    std::lock_guard<std::mutex> probeLock(probe->mutex);
+                    if (ok) {
+                        probe->total = static_cast<unsigned long long>(stats.f_blocks) * stats.f_frsize;
+                        probe->used = static_cast<unsigned long long>(stats.f_blocks - stats.f_bfree) * stats.f_frsize;
+                    }
+                    probe->ok = ok;
+                    probe->finished = true;
+                    probe->done.notify_all();
+                }).detach();
+            } catch (const std::system_error&) {
+                continue;
+            }
+            std::unique_lock<std::mutex> probeLock(probe->mutex);
+            finished = probe->done.wait_for(probeLock, statTimeout, [&probe]() { return probe->finished; });
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto mount = std::find_if(mounts.begin(), mounts.end(),
+                                  [&](const Mount& m) { return m.info.mountPoint == mountPoint; });
+        if (mount == mounts.end()) {
+            continue;
+        }
+        if (!finished) {
+            mount->info.stale = true;
+            mount->pending = probe;
+        } else {
+            mount->pending.reset();
+            mount->info.stale = false;
+            if (probe->ok) {
+                mount->info.totalSpace = probe->total;
+                mount->info.usedSpace = probe->used;
+                mount->sampled = true;
+            }
+        }
+        ++generation;
+    }
+}
+
+void MountMonitor::runCapacityThread() {
+    while (running) {
+        sampleCapacities();
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait_for(lock, capacityInterval, [this]() { return !running || mountsChanged; });
+    }
+}
@@ -0,0 +1,110 @@
+#include "../include/netlink_socket.h"
+#include "../include/self_stats.h"
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+
+NetlinkMessageWriter::NetlinkMessageWriter(std::vector<char>& buffer) : buffer(buffer), messageStart(0) {}
+
+void NetlinkMessageWriter::begin(uint16_t type, uint16_t flags, uint32_t sequence) {
+    messageStart = buffer.size();
+    struct nlmsghdr header = {};
+    header.nlmsg_type = type;
+    header.nlmsg_flags = flags;
+    header.nlmsg_seq = sequence;
+    appendAligned(&header, sizeof(header));
+}
+
+void NetlinkMessageWriter::appendHeader(const void* header, size_t length) {
+    appendAligned(header, length);
+}
+
+void NetlinkMessageWriter::addAttribute(uint16_t type, const void* data, size_t length) {
+    struct nlattr attribute = {};
+    attribute.nla_type = type;
+    attribute.nla_len = static_cast<uint16_t>(NLA_HDRLEN + length);
+    appendAligned(&attribute, sizeof(attribute));
+    appendAligned(data, length);
+}
+
+void NetlinkMessageWriter::end() {
+    auto* header = reinterpret_cast<struct nlmsghdr*>(buffer.data() + messageStart);
+    header->nlmsg_len = static_cast<uint32_t>(buffer.size() - messageStart);
+}
+
+void NetlinkMessageWriter::appendAligned(const void* data, size_t length) {
+    size_t offset = buffer.size();
+    buffer.resize(offset + NLMSG_ALIGN(length), 0);
+    memcpy(buffer.data() + offset, data, length);
+}
+
+NetlinkSocket::NetlinkSocket() : sock(-1), sequence(0) {}
+
+NetlinkSocket::~NetlinkSocket() {
+    close();
+}
+
+bool NetlinkSocket::open(int protocol, uint32_t groups, std::string& error) {
+    sock = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, protocol);
+    if (sock < 0) {
+        error = std::string("socket: ") + strerror(errno);
+        return false;
+    }
+
+    struct sockaddr_nl address = {};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = groups;
+    if (bind(sock, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) {
+        error = std::string("bind: ") + strerror(errno);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void NetlinkSocket::close() {
+    if (sock >= 0) {
+        ::close(sock);
+        sock = -1;
+    }
+}
+
+bool NetlinkSocket::isOpen() const {
+    return sock >= 0;
+}
+
+int NetlinkSocket::fd() const {
+    return sock;
+}
+
+uint32_t NetlinkSocket::nextSequence() {
+    return ++sequence;
+}
+
+bool NetlinkSocket::send(const std::vector<char>& messages) {
+    struct sockaddr_nl kernel = {};
+    kernel.nl_family = AF_NETLINK;
+    while (true) {
+        ssize_t sent = sendto(sock, messages.data(), messages.size(), 0,
+                              reinterpret_cast<struct sockaddr*>(&kernel), sizeof(kernel));
+        if (sent < 0 && errno == EINTR) continue;
+        return sent == static_cast<ssize_t>(messages.size());
+    }
+}
+
+ssize_t NetlinkSocket::receive(std::vector<char>& buffer, bool block) {
+    if (buffer.size() < 65536) {
+        buffer.resize(65536);
+    }
+    while (true) {
+        ssize_t length = recv(sock, buffer.data(), buffer.size(), block ? 0 : MSG_DONTWAIT);
+        if (length < 0) {
+            if (errno == EINTR) continue;
+            if (!block && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+        } else {
+            countRead(static_cast<size_t>(length));
+        }
+        return length;
+    }
+}
@@ -1,116 +1,312 @@
 #include "../include/network_monitor.h"
-#include <fstream>
-#include <sstream>
 #include <filesystem>
-#include <iostream>
 #include <algorithm>
+#include <cerrno>
 #include <cstring>
 #include <sys/socket.h>
-#include <sys/ioctl.h>
-#include <netinet/in.h>
 #include <arpa/inet.h>
 #include <net/if.h>
-#include <unistd.h>
+#include <net/if_arp.h>
+#include <linux/if_link.h>
+#include <linux/rtnetlink.h>
 
-NetworkMonitor::NetworkMonitor() {
+namespace {
+
+// IF_OPER_* from <linux/if.h>, which cannot be included alongside <net/if.h>
+constexpr unsigned char OPER_UNKNOWN = 0;
+constexpr unsigned char OPER_UP = 6;
+
+unsigned long long delta(unsigned long long before, unsigned long long after) {
+    return after > before ? after - before : 0;
+}
+
+}
+
+NetworkMonitor::NetworkMonitor() : addressesStale(true) {
     lastUpdateTime = std::chrono::steady_clock::now();
+    if (!dumpSocket.open(NETLINK_ROUTE, 0, error)) {
+        error = "rtnetlink " + error;
+        return;
+    }
+    std::string addressError;
+    if (!addressSocket.open(NETLINK_ROUTE, RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR, addressError)) {
+        // addresses are then dumped again every tick instead
+        error = "rtnetlink address notifications " + addressError;
+    }
 }
 
 void NetworkMonitor::update() {
+    if (!dumpSocket.isOpen()) {
+        return;
+    }
     auto currentTime = std::chrono::steady_clock::now();
     double elapsedSeconds = std::chrono::duration<double>(currentTime - lastUpdateTime).count();
 
-    for (const auto& entry : std::filesystem::directory_iterator("/sys/class/net/")) {
-        std::string interfaceName = entry.path().filename();
-        if (isInterfaceActive(interfaceName)) {
-            std::string interfaceType = getInterfaceType(interfaceName);
-
-            if (interfaceType == "ethernet" || interfaceType == "wireless") {
-                unsigned long long bytesReceived = readSysfsValue(interfaceName, "statistics/rx_bytes");
-                unsigned long long bytesSent = readSysfsValue(interfaceName, "statistics/tx_bytes");
-
-                auto it = interfaces.find(interfaceName);
-                if (it == interfaces.end()) {
-                    interfaces[interfaceName] = {interfaceName, interfaceType, getIpAddress(interfaceName), bytesReceived, bytesSent, 0, 0, 0, 0};
-                    it = interfaces.find(interfaceName);
-                }
-
-                double downloadSpeed = (bytesReceived - it->second.bytesReceived) / elapsedSeconds;
-                double uploadSpeed = (bytesSent - it->second.bytesSent) / elapsedSeconds;
-
-                it->second.downloadSpeed = downloadSpeed;
-                it->second.uploadSpeed = uploadSpeed;
-                it->second.maxDownloadSpeed = std::max(it->second.maxDownloadSpeed, downloadSpeed);
-                it->second.maxUploadSpeed = std::max(it->second.maxUploadSpeed, uploadSpeed);
-                it->second.bytesReceived = bytesReceived;
-                it->second.bytesSent = bytesSent;
-            }
+    drainAddressEvents();
+    if (addressesStale || !addressSocket.isOpen()) {
+        addresses.clear();
+        addressesStale = !dump(RTM_GETADDR, AF_UNSPEC, 0);
+    }
+
+    for (auto& pair : links) {
+        pair.second.seen = false;
+    }
+    if (!dump(RTM_GETLINK, AF_UNSPEC, elapsedSeconds)) {
+        return;
+    }
+    for (auto it = links.begin(); it != links.end();) {
+        if (it->second.seen) {
+            ++it;
+        } else {
+            addresses.erase(it->first);
+            it = links.erase(it);
         }
     }
 
+    activeInterfaces.clear();
+    for (const auto& pair : links) {
+        // loopback traffic never leaves the machine
+        if (pair.second.active && pair.second.info.type != "loopback") {
+            activeInterfaces.push_back(pair.second.info);
+            activeInterfaces.back().ipAddress = primaryAddress(pair.first);
+        }
+    }
+    std::sort(activeInterfaces.begin(), activeInterfaces.end(),
+              [](const NetworkInterface& a, const NetworkInterface& b) { return a.name < b.name; });
+
     lastUpdateTime = currentTime;
 }
 
 std::vector<NetworkInterface> NetworkMonitor::getActiveInterfaces() const {
-    std::vector<NetworkInterface> activeInterfaces;
-    for (const auto& pair : interfaces) {
-        if (isInterfaceActive(pair.first)) {
-            activeInterfaces.push_back(pair.second);
+    return activeInterfaces;
+}
+
+bool NetworkMonitor::hasLink(int index, const std::string& name) const {
+    auto it = links.find(index);
+    return it != links.end() && it->second.info.name == name;
+}
+
+const std::string& NetworkMonitor::getError() const {
+    return error;
+}
+
+bool NetworkMonitor::dump(uint16_t type, unsigned char family, double elapsedSeconds) {
+    requestBuffer.clear();
+    NetlinkMessageWriter writer(requestBuffer);
+    uint32_t sequence = dumpSocket.nextSequence();
+    writer.begin(type, NLM_F_REQUEST | NLM_F_DUMP, sequence);
+    if (type == RTM_GETLINK) {
+        struct ifinfomsg request = {};
+        request.ifi_family = family;
+        writer.appendHeader(&request, sizeof(request));
+    } else {
+        struct ifaddrmsg request = {};
+        request.ifa_family = family;
+        writer.appendHeader(&request, sizeof(request));
+    }
+    writer.end();
+    if (!dumpSocket.send(requestBuffer)) {
+        return false;
+    }
+
+    // a dump arrives as several datagrams of many messages each, ended by NLMSG_DONE
+    while (true) {
+        ssize_t length = dumpSocket.receive(receiveBuffer, true);
+        if (length < 0) {
+            return false;
+        }
+        for (auto* header = reinterpret_cast<const struct nlmsghdr*>(receiveBuffer.data());
+             NLMSG_OK(header, static_cast<size_t>(length)); header = NLMSG_NEXT(header, length)) {
+            if (header->nlmsg_seq != sequence) {
+                continue;
+            }
+            if (header->nlmsg_type == NLMSG_DONE) {
+                return true;
+            }
+            if (header->nlmsg_type == NLMSG_ERROR) {
+                return false;
+            }
+            handleMessage(header, elapsedSeconds);
         }
     }
-    return activeInterfaces;
 }
 
-std::string NetworkMonitor::getInterfaceType(const std::string& name) const {
-    std::string path = "/sys/class/net/" + name;
-    if (std::filesystem::exists(path + "/wireless")) {
-        return "wireless";
-    } else if (std::filesystem::exists(path + "/device")) {
-        return "ethernet";
-    } else if (name == "lo") {
-        return "loopback";
+void NetworkMonitor::handleMessage(const struct nlmsghdr* header, double elapsedSeconds) {
+    switch (header->nlmsg_type) {
+        case RTM_NEWLINK:
+            handleLink(header, elapsedSeconds);
+            break;
+        case RTM_NEWADDR:
+        case RTM_DELADDR:
+            handleAddress(header);
+            break;
+        default:
+            break;
     }
-    return "unknown";
 }
 
-bool NetworkMonitor::isInterfaceActive(const std::string& name) const {
-    std::string operstatePath = "/sys/class/net/" + name + "/operstate";
-    std::ifstream operstate(operstatePath);
-    std::string state;
-    if (operstate >> state) {
-        return state == "up";
+void NetworkMonitor::handleLink(const struct nlmsghdr* header, double elapsedSeconds) {
+    if (header->nlmsg_len < NLMSG_LENGTH(sizeof(struct ifinfomsg))) {
+        return;
+    }
+    auto* link = static_cast<const struct ifinfomsg*>(NLMSG_DATA(header));
+    std::string name;
+    std::string kind;
+    unsigned char operstate = OPER_UNKNOWN;
+    struct rtnl_link_stats64 stats = {};
+    forEachNetlinkAttribute(IFLA_RTA(link), IFLA_PAYLOAD(header), [&](uint16_t type, const char* data, size_t length) {
+        switch (type) {
+            case IFLA_IFNAME:
+                name.assign(data, strnlen(data, length));
+                break;
+            case IFLA_OPERSTATE:
+                if (length >= 1) operstate = static_cast<unsigned char>(data[0]);
+                break;
+            case IFLA_STATS64:
+                // the struct has grown over kernel versions; older kernels send a shorter one
+                memcpy(&stats, data, std::min(length, sizeof(stats)));
+                break;
+            case IFLA_LINKINFO:
+                forEachNetlinkAttribute(data, length, [&](uint16_t infoType, const char* info, size_t infoLength) {
+                    if (infoType == IFLA_INFO_KIND) kind.assign(info, strnlen(info, infoLength));
+                });
+                break;
+            default:
+                break;
+        }
+    });
+    if (name.empty()) {
+        return;
+    }
+
+    auto inserted = links.try_emplace(link->ifi_index);
+    Link& entry = inserted.first->second;
+    NetworkInterface& info = entry.info;
+    if (inserted.second || info.name != name) {
+        info = {};
+        info.index = link->ifi_index;
+        info.name = name;
+        info.type = getInterfaceType(name, link->ifi_type, kind);
+        entry.packetsReceived = stats.rx_packets;
+        entry.packetsSent = stats.tx_packets;
+        info.bytesReceived = stats.rx_bytes;
+        info.bytesSent = stats.tx_bytes;
     }
-    return false;
+
+    if (elapsedSeconds > 0) {
+        info.downloadSpeed = delta(info.bytesReceived, stats.rx_bytes) / elapsedSeconds;
+        info.uploadSpeed = delta(info.bytesSent, stats.tx_bytes) / elapsedSeconds;
+        info.packetsReceivedPerSec = delta(entry.packetsReceived, stats.rx_packets) / elapsedSeconds;
+        info.packetsSentPerSec = delta(entry.packetsSent, stats.tx_packets) / elapsedSeconds;
+        info.maxDownloadSpeed = std::max(info.maxDownloadSpeed, info.downloadSpeed);
+        info.maxUploadSpeed = std::max(info.maxUploadSpeed, info.uploadSpeed);
+    }
+    info.bytesReceived = stats.rx_bytes;
+    info.bytesSent = stats.tx_bytes;
+    info.totalBytesReceived = stats.rx_bytes;
+    info.totalBytesSent = stats.tx_bytes;
+    info.receiveErrors = stats.rx_errors;
+    info.sendErrors = stats.tx_errors;
+    info.receiveDropped = stats.rx_dropped;
+    info.sendDropped = stats.tx_dropped;
+    entry.packetsReceived = stats.rx_packets;
+    entry.packetsSent = stats.tx_packets;
+
+    // loopback and many virtual links never leave the unknown operstate; IFF_RUNNING stands in for them
+    bool up = operstate == OPER_UP || (operstate == OPER_UNKNOWN && (link->ifi_flags & IFF_RUNNING));
+    entry.active = (link->ifi_flags & IFF_UP) && up;
+    entry.seen = true;
 }
 
-unsigned long long NetworkMonitor::readSysfsValue(const std::string& interface, const std::string& file) const {
-    std::string path = "/sys/class/net/" + interface + "/" + file;
-    std::ifstream ifs(path);
-    if (!ifs) {
-        std::cerr << "Failed to open " << path << std::endl;
-        return 0;
+void NetworkMonitor::handleAddress(const struct nlmsghdr* header) {
+    if (header->nlmsg_len < NLMSG_LENGTH(sizeof(struct ifaddrmsg))) {
+        return;
+    }
+    auto* message = static_cast<const struct ifaddrmsg*>(NLMSG_DATA(header));
+    size_t addressLength = message->ifa_family == AF_INET ? 4 : message->ifa_family == AF_INET6 ? 16 : 0;
+    if (addressLength == 0) {
+        return;
+    }
+    // IFA_LOCAL is the interface's own address; on point-to-point links IFA_ADDRESS is the peer
+    const char* local = nullptr;
+    const char* address = nullptr;
+    forEachNetlinkAttribute(IFA_RTA(message), IFA_PAYLOAD(header), [&](uint16_t type, const char* data, size_t length) {
+        if (length < addressLength) return;
+        if (type == IFA_LOCAL) local = data;
+        else if (type == IFA_ADDRESS) address = data;
+    });
+    const char* chosen = local ? local : address;
+    char text[INET6_ADDRSTRLEN];
+    if (!chosen || !inet_ntop(message->ifa_family, chosen, text, sizeof(text))) {
+        return;
+    }
+
+    auto& list = addresses[static_cast<int>(message->ifa_index)];
+    auto it = std::find_if(list.begin(), list.end(), [&](const Address& entry) { return entry.text == text; });
+    if (header->nlmsg_type == RTM_DELADDR) {
+        if (it != list.end()) {
+            list.erase(it);
+        }
+    } else if (it == list.end()) {
+        list.push_back({message->ifa_family, message->ifa_scope, text});
     }
-    unsigned long long value;
-    ifs >> value;
-    return value;
 }
 
-std::string NetworkMonitor::getIpAddress(const std::string& interface) const {
-    int fd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (fd == -1) {
-        std::cerr << "Failed to create socket" << std::endl;
-        return "";
+void NetworkMonitor::drainAddressEvents() {
+    if (!addressSocket.isOpen()) {
+        return;
+    }
+    while (true) {
+        ssize_t length = addressSocket.receive(receiveBuffer, false);
+        if (length == 0) {
+            return;
+        }
+        if (length < 0) {
+            if (errno != ENOBUFS) {
+                return;
+            }
+            // notifications were dropped, so the list can no longer be trusted
+            addressesStale = true;
+            continue;
+        }
+        for (auto* header = reinterpret_cast<const struct nlmsghdr*>(receiveBuffer.data());
+             NLMSG_OK(header, static_cast<size_t>(length)); header = NLMSG_NEXT(header, length)) {
+            handleMessage(header, 0);
+        }
     }
+}
 
-    struct ifreq ifr;
-    ifr.ifr_addr.sa_family = AF_INET;
-    strncpy(ifr.ifr_name, interface.c_str(), IFNAMSIZ - 1);
+std::string NetworkMonitor::getInterfaceType(const std::string& name, unsigned short arpType, const std::string& kind) const {
+    if (arpType == ARPHRD_LOOPBACK) {
+        return "loopback";
+    }
+    if (!kind.empty()) {
+        return kind;
+    }
+    // only checked when a link first shows up, so the sysfs lookup is not on the tick path
+    std::error_code ec;
+    if (std::filesystem::exists("/sys/class/net/" + name + "/wireless", ec)) {
+        return "wireless";
+    }
+    if (arpType == ARPHRD_ETHER) {
+        return "ethernet";
+    }
+    return "unknown";
+}
 
-    if (ioctl(fd, SIOCGIFADDR, &ifr) == -1) {
-        close(fd);
+std::string NetworkMonitor::primaryAddress(int index) const {
+    auto it = addresses.find(index);
+    if (it == addresses.end()) {
         return "";
     }
-
-    close(fd);
-    return inet_ntoa(((struct sockaddr_in *)&ifr.ifr_addr)->sin_addr);
-}
\ No newline at end of file
+    const Address* best = nullptr;
+    for (const auto& address : it->second) {
+        if (address.family == AF_INET) {
+            return address.text;
+        }
+        if (!best && address.scope == RT_SCOPE_UNIVERSE) {
+            best = &address;
+        }
+    }
+    return best ? best->text : "";
+}
@@ -0,0 +1,334 @@
+#include "../include/packet_flow_monitor.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+
+namespace {
+
+// kernel blocks must be a multiple of the page size; 1 MiB keeps the block count for a
+// typical ring in the tens
+constexpr size_t BLOCK_SIZE = 1 << 20;
+constexpr unsigned int FRAME_SIZE = 2048;
+// a block that is only partly filled is still handed over after this long, so a quiet link
+// does not hold packets back from update()
+constexpr unsigned int BLOCK_TIMEOUT_MS = 20;
+
+constexpr uint8_t IPV6_HOP_BY_HOP = 0;
+constexpr uint8_t IPV6_ROUTING = 43;
+constexpr uint8_t IPV6_FRAGMENT = 44;
+constexpr uint8_t IPV6_DESTINATION = 60;
+
+const uint8_t V4_MAPPED_PREFIX[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+
+uint16_t readPort(const uint8_t* data) {
+    return static_cast<uint16_t>(data[0] << 8 | data[1]);
+}
+
+bool isV4Mapped(const uint8_t* address) {
+    return memcmp(address, V4_MAPPED_PREFIX, sizeof(V4_MAPPED_PREFIX)) == 0;
+}
+
+bool isUnspecified(const uint8_t* address, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        if (address[i] != 0) return false;
+    }
+    return true;
+}
+
+}
+
+bool PacketFlowMonitor::FlowKey::operator==(const FlowKey& other) const {
+    return memcmp(this, &other, sizeof(FlowKey)) == 0;
+}
+
+size_t PacketFlowMonitor::FlowKeyHash::operator()(const FlowKey& key) const {
+    static_assert(sizeof(FlowKey) == 38, "FlowKey must not contain padding");
+    return std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char*>(&key), sizeof(key)));
+}
+
+PacketFlowMonitor::PacketFlowMonitor(const Config& config)
+    : interface(config.getPacketCaptureInterface()), blockSize(BLOCK_SIZE),
+      blockCount(static_cast<unsigned int>(std::max(config.getPacketRingMb(), 1))),
+      snaplen(static_cast<unsigned int>(std::max(config.getPacketSnaplen(), 64))), fd(-1), ring(nullptr),
+      running(false), packets(0), rates(std::make_shared<const ProcessNetworkRates>()), stats{} {
+    lastUpdate = std::chrono::steady_clock::now();
+}
+
+PacketFlowMonitor::~PacketFlowMonitor() {
+    stop();
+}
+
+bool PacketFlowMonitor::start(std::string& error) {
+    if (running) {
+        return true;
+    }
+    if (!diagSocket.open(NETLINK_SOCK_DIAG, 0, error)) {
+        error = "sock_diag " + error;
+        return false;
+    }
+
+    // SOCK_DGRAM: the ring holds packets from the network header on, whatever the link type
+    fd = socket(AF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC, htons(ETH_P_ALL));
+    if (fd < 0) {
+        error = std::string("packet socket: ") + strerror(errno);
+        return false;
+    }
+
+    // attached before bind, so no packet reaches the ring untruncated
+    struct sock_filter truncate[] = {BPF_STMT(BPF_RET | BPF_K, snaplen)};
+    struct sock_fprog program = {1, truncate};
+    int version = TPACKET_V3;
+    struct tpacket_req3 request = {};
+    request.tp_block_size = static_cast<unsigned int>(blockSize);
+    request.tp_block_nr = blockCount;
+    request.tp_frame_size = FRAME_SIZE;
+    request.tp_frame_nr = static_cast<unsigned int>(blockSize / FRAME_SIZE) * blockCount;
+    request.tp_retire_blk_tov = BLOCK_TIMEOUT_MS;
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program)) != 0 ||
+        setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0 ||
+        setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &request, sizeof(request)) != 0) {
+        error = std::string("packet ring setup: ") + strerror(errno);
+        closeRing();
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, blockSize * blockCount, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        error = std::string("packet ring mmap: ") + strerror(errno);
+        closeRing();
+        return false;
+    }
+    ring = static_cast<uint8_t*>(mapped);
+
+    struct sockaddr_ll address = {};
+    address.sll_family = AF_PACKET;
+    address.sll_protocol = htons(ETH_P_ALL);
+    address.sll_ifindex = interface.empty() ? 0 : static_cast<int>(if_nametoindex(interface.c_str()));
+    if ((!interface.empty() && address.sll_ifindex == 0) ||
+        bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) {
+        error = "packet capture on " + (interface.empty() ? std::string("all interfaces") : interface) + ": " +
+                strerror(errno);
+        closeRing();
+        return false;
+    }
+
+    running = true;
+    captureThread = std::thread(&PacketFlowMonitor::runCapture, this);
+    return true;
+}
+
+void PacketFlowMonitor::stop() {
+    running = false;
+    if (captureThread.joinable()) {
+        captureThread.join();
+    }
+    closeRing();
+}
+
+void PacketFlowMonitor::closeRing() {
+    if (ring) {
+        munmap(ring, blockSize * blockCount);
+        ring = nullptr;
+    }
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+void PacketFlowMonitor::runCapture() {
+    unsigned int current = 0;
+    while (running) {
+        uint8_t* block = ring + static_cast<size_t>(current) * blockSize;
+        auto* descriptor = reinterpret_cast<struct tpacket_block_desc*>(block);
+        if (!(__atomic_load_n(&descriptor->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER)) {
+            // the timeout bounds how long stop() waits
+            struct pollfd pfd = {fd, POLLIN | POLLERR, 0};
+            poll(&pfd, 1, 100);
+            continue;
+        }
+        readBlock(block);
+        __atomic_store_n(&descriptor->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        current = (current + 1) % blockCount;
+    }
+}
+
+void PacketFlowMonitor::readBlock(const uint8_t* block) {
+    auto* descriptor = reinterpret_cast<const struct tpacket_block_desc*>(block);
+    uint32_t count = descriptor->hdr.bh1.num_pkts;
+    const uint8_t* packet = block + descriptor->hdr.bh1.offset_to_first_pkt;
+
+    // one lock per block rather than per packet
+    std::lock_guard<std::mutex> lock(flowMutex);
+    for (uint32_t i = 0; i < count; ++i) {
+        auto* header = reinterpret_cast<const struct tpacket3_hdr*>(packet);
+        auto* link = reinterpret_cast<const struct sockaddr_ll*>(packet + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+        const uint8_t* data = packet + header->tp_net;
+        size_t length = header->tp_snaplen;
+        bool outgoing = link->sll_pkttype == PACKET_OUTGOING;
+        packet += header->tp_next_offset;
+
+        // the flow is keyed from this host's side: the source of what it sends, the
+        // destination of what it receives
+        FlowKey key = {};
+        const uint8_t* source;
+        const uint8_t* destination;
+        const uint8_t* transport;
+        uint16_t protocol = ntohs(link->sll_protocol);
+        if (protocol == ETH_P_IP && length >= 20) {
+            size_t headerLength = static_cast<size_t>(data[0] & 0x0f) * 4;
+            key.family = AF_INET;
+            key.protocol = data[9];
+            source = data + 12;
+            destination = data + 16;
+            // fragments after the first carry no transport header
+            bool laterFragment = (readPort(data + 6) & 0x1fff) != 0;
+            transport = !laterFragment && length >= headerLength + 4 ? data + headerLength : nullptr;
+            memcpy(outgoing ? key.local : key.remote, source, 4);
+            memcpy(outgoing ? key.remote : key.local, destination, 4);
+        } else if (protocol == ETH_P_IPV6 && length >= 40) {
+            key.family = AF_INET6;
+            uint8_t next = data[6];
+            size_t offset = 40;
+            bool laterFragment = false;
+            while ((next == IPV6_HOP_BY_HOP || next == IPV6_ROUTING || next == IPV6_DESTINATION ||
+                    next == IPV6_FRAGMENT) && length >= offset + 8) {
+                size_t extension = 8;
+                if (next == IPV6_FRAGMENT) {
+                    // the offset is the top 13 bits of the second half-word
+                    laterFragment = laterFragment || (readPort(data + offset + 2) & 0xfff8) != 0;
+                } else {
+                    extension = (static_cast<size_t>(data[offset + 1]) + 1) * 8;
+                }
+                next = data[offset];
+                offset += extension;
+            }
+            key.protocol = next;
+            source = data + 8;
+            destination = data + 24;
+            transport = !laterFragment && length >= offset + 4 ? data + offset : nullptr;
+            memcpy(outgoing ? key.local : key.remote, source, 16);
+            memcpy(outgoing ? key.remote : key.local, destination, 16);
+        } else {
+            continue;
+        }
+        if (transport && (key.protocol == IPPROTO_TCP || key.protocol == IPPROTO_UDP)) {
+            key.localPort = readPort(outgoing ? transport : transport + 2);
+            key.remotePort = readPort(outgoing ? transport + 2 : transport);
+        }
+
+        FlowBytes& bytes = flows[key];
+        (outgoing ? bytes.sent : bytes.received) += header->tp_len;
+    }
+    packets.fetch_add(count, std::memory_order_relaxed);
+}
+
+void PacketFlowMonitor::update() {
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - lastUpdate).count();
+    lastUpdate = now;
+    if (!running || seconds <= 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(flowMutex);
+        flows.swap(drained);
+    }
+
+    sockets.clear();
+    socketsByFlow.clear();
+    indexSockets(IPPROTO_TCP);
+    indexSockets(IPPROTO_UDP);
+    ownerIndex.update(sockets);
+
+    auto next = std::make_shared<ProcessNetworkRates>();
+    double unattributed = 0;
+    for (const auto& [key, bytes] : drained) {
+        int pid = ownerIndex.ownerOf(findSocket(key));
+        if (pid == 0) {
+            unattributed += static_cast<double>(bytes.received + bytes.sent);
+            continue;
+        }
+        ProcessNetworkRate& rate = (*next)[pid];
+        rate.receiveBytesPerSec += static_cast<double>(bytes.received) / seconds;
+        rate.sendBytesPerSec += static_cast<double>(bytes.sent) / seconds;
+    }
+    std::atomic_store(&rates, std::shared_ptr<const ProcessNetworkRates>(std::move(next)));
+
+    // reading the kernel's counters resets them
+    struct tpacket_stats_v3 kernelStats = {};
+    socklen_t length = sizeof(kernelStats);
+    getsockopt(fd, SOL_PACKET, PACKET_STATISTICS, &kernelStats, &length);
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats.packets = packets.load(std::memory_order_relaxed);
+    stats.drops += kernelStats.tp_drops;
+    stats.flows = drained.size();
+    stats.unattributedBytesPerSec = unattributed / seconds;
+    drained.clear();
+}
+
+void PacketFlowMonitor::indexSockets(uint8_t protocol) {
+    auto add = [this, protocol](const struct inet_diag_msg& message, const void*, size_t) {
+        if (message.idiag_inode == 0) {
+            return;
+        }
+        FlowKey key = {};
+        key.family = message.idiag_family;
+        key.protocol = protocol;
+        key.localPort = ntohs(message.id.idiag_sport);
+        key.remotePort = ntohs(message.id.idiag_dport);
+        size_t addressLength = key.family == AF_INET ? 4 : 16;
+        memcpy(key.local, message.id.idiag_src, addressLength);
+        memcpy(key.remote, message.id.idiag_dst, addressLength);
+        sockets.push_back({message.idiag_inode, message.idiag_uid});
+        socketsByFlow[key] = message.idiag_inode;
+
+        // dual-stack sockets see IPv4 traffic under v4-mapped (or unspecified) IPv6 addresses
+        bool localMapped = isV4Mapped(key.local) || isUnspecified(key.local, 16);
+        bool remoteMapped = isV4Mapped(key.remote) || isUnspecified(key.remote, 16);
+        if (key.family == AF_INET6 && localMapped && remoteMapped) {
+            FlowKey v4 = key;
+            v4.family = AF_INET;
+            memset(v4.local, 0, sizeof(v4.local));
+            memset(v4.remote, 0, sizeof(v4.remote));
+            memcpy(v4.local, key.local + 12, 4);
+            memcpy(v4.remote, key.remote + 12, 4);
+            socketsByFlow.emplace(v4, message.idiag_inode);
+        }
+    };
+    dumpInetSockets(diagSocket, protocol, 0, requestBuffer, receiveBuffer, add, diagError);
+}
+
+unsigned long long PacketFlowMonitor::findSocket(FlowKey key) const {
+    // connected sockets match on both ends; listeners and unconnected UDP sockets only on the
+    // local end, possibly bound to the wildcard address
+    auto it = socketsByFlow.find(key);
+    if (it != socketsByFlow.end()) return it->second;
+    memset(key.remote, 0, sizeof(key.remote));
+    key.remotePort = 0;
+    it = socketsByFlow.find(key);
+    if (it != socketsByFlow.end()) return it->second;
+    memset(key.local, 0, sizeof(key.local));
+    it = socketsByFlow.find(key);
+    return it != socketsByFlow.end() ? it->second : 0;
+}
+
+std::shared_ptr<const ProcessNetworkRates> PacketFlowMonitor::getRates() const {
+    return std::atomic_load(&rates);
+}
+
+PacketCaptureStats PacketFlowMonitor::getStats() const {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return stats;
+}
@@ -0,0 +1,159 @@
+#include "../include/pressure_monitor.h"
+#include "../include/proc_io.h"
+#include "../include/proc_parsers.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+const char* const PRESSURE_PATHS[] = {"/proc/pressure/cpu", "/proc/pressure/memory", "/proc/pressure/io"};
+
+// avg values are printed with two decimals ("1.46")
+bool parseDecimal(std::string_view text, double& value) {
+    unsigned long long whole = 0, fraction = 0;
+    size_t dot = text.find('.');
+    std::string_view wholeText = text.substr(0, dot);
+    if (!parseUnsigned(wholeText, whole) || !wholeText.empty()) {
+        return false;
+    }
+    double scale = 1.0;
+    if (dot != std::string_view::npos) {
+        std::string_view fractionText = text.substr(dot + 1);
+        size_t digits = fractionText.size();
+        if (!parseUnsigned(fractionText, fraction) || !fractionText.empty()) {
+            return false;
+        }
+        for (size_t i = 0; i < digits; ++i) {
+            scale *= 10.0;
+        }
+    }
+    value = static_cast<double>(whole) + static_cast<double>(fraction) / scale;
+    return true;
+}
+
+bool parsePressureLine(std::string_view line, PressureStats& stats) {
+    int parsed = 0;
+    while (!line.empty()) {
+        std::string_view field = nextToken(line);
+        size_t equals = field.find('=');
+        if (equals == std::string_view::npos) {
+            continue;
+        }
+        std::string_view key = field.substr(0, equals);
+        std::string_view value = field.substr(equals + 1);
+        if (key == "avg10") parsed += parseDecimal(value, stats.avg10);
+        else if (key == "avg60") parsed += parseDecimal(value, stats.avg60);
+        else if (key == "avg300") parsed += parseDecimal(value, stats.avg300);
+        else if (key == "total") parsed += parseUnsigned(value, stats.total);
+    }
+    return parsed == 4;
+}
+
+}
+
+PressureMonitor::PressureMonitor(const Config& config) : pressure{} {
+    for (size_t i = 0; i < RESOURCE_COUNT; ++i) {
+        auto resource = static_cast<PressureResource>(i);
+        readFds[i] = openProcFile(PRESSURE_PATHS[i]);
+        triggerFds[i] = -1;
+        triggers[i] = config.getPressureTrigger(resourceName(resource));
+        if (readFds[i] >= 0 && !triggers[i].empty()) {
+            registerTrigger(i, PRESSURE_PATHS[i]);
+        }
+    }
+    update();
+}
+
+PressureMonitor::~PressureMonitor() {
+    for (size_t i = 0; i < RESOURCE_COUNT; ++i) {
+        closeProcFile(readFds[i]);
+        closeProcFile(triggerFds[i]);
+    }
+}
+
+void PressureMonitor::registerTrigger(size_t index, const std::string& path) {
+    // each trigger needs its own descriptor; the kernel keeps it armed until that is closed
+    int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd >= 0 && write(fd, triggers[index].c_str(), triggers[index].size() + 1) >= 0) {
+        triggerFds[index] = fd;
+        return;
+    }
+    // creating triggers takes CAP_SYS_RESOURCE, or since 6.5 a window that is a multiple of 2s
+    if (!triggerError.empty()) {
+        triggerError += "; ";
+    }
+    int error = errno;
+    triggerError += std::string(resourceName(static_cast<PressureResource>(index))) + ": " + strerror(error);
+    if (error == EINVAL) {
+        triggerError += " (without CAP_SYS_RESOURCE the window must be a multiple of 2s)";
+    }
+    closeProcFile(fd);
+}
+
+void PressureMonitor::update() {
+    for (size_t i = 0; i < RESOURCE_COUNT; ++i) {
+        auto& current = pressure[i];
+        current.available = false;
+        current.hasFull = false;
+        if (readFds[i] < 0) {
+            continue;
+        }
+        // with psi=0 on the command line the files exist but reads fail with EOPNOTSUPP
+        auto content = readProcFile(readFds[i], buffer);
+        if (!content) {
+            continue;
+        }
+        std::string_view rest = *content;
+        while (!rest.empty()) {
+            std::string_view line = nextLine(rest);
+            std::string_view kind = nextToken(line);
+            if (kind == "some") {
+                current.available = parsePressureLine(line, current.some);
+            } else if (kind == "full") {
+                current.hasFull = parsePressureLine(line, current.full);
+            }
+        }
+    }
+}
+
+const ResourcePressure& PressureMonitor::get(PressureResource resource) const {
+    return pressure[static_cast<size_t>(resource)];
+}
+
+bool PressureMonitor::isAvailable() const {
+    for (const auto& current : pressure) {
+        if (current.available) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int PressureMonitor::getTriggerFd(PressureResource resource) const {
+    return triggerFds[static_cast<size_t>(resource)];
+}
+
+void PressureMonitor::dropTrigger(PressureResource resource) {
+    size_t index = static_cast<size_t>(resource);
+    closeProcFile(triggerFds[index]);
+    triggerFds[index] = -1;
+}
+
+const std::string& PressureMonitor::getTrigger(PressureResource resource) const {
+    return triggers[static_cast<size_t>(resource)];
+}
+
+const std::string& PressureMonitor::getTriggerError() const {
+    return triggerError;
+}
+
+const char* PressureMonitor::resourceName(PressureResource resource) {
+    switch (resource) {
+        case PressureResource::Cpu: return "cpu";
+        case PressureResource::Memory: return "memory";
+        case PressureResource::Io: return "io";
+    }
+    return "";
+}
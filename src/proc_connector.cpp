@@ -0,0 +1,160 @@
+#include "../include/proc_connector.h"
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+
+namespace {
+constexpr int RECEIVE_BUFFER_SIZE = 4 * 1024 * 1024;
+constexpr int ACK_TIMEOUT_MS = 200;
+}
+
+ProcConnector::ProcConnector() : sock(-1) {}
+
+ProcConnector::~ProcConnector() {
+    if (sock >= 0) {
+        sendListen(false);
+        close(sock);
+    }
+}
+
+bool ProcConnector::open(std::string& error) {
+    sock = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (sock < 0) {
+        error = std::string("socket: ") + strerror(errno);
+        return false;
+    }
+
+    // a fork storm can queue a lot of events between ticks; try to make room for them
+    int bufferSize = RECEIVE_BUFFER_SIZE;
+    if (setsockopt(sock, SOL_SOCKET, SO_RCVBUFFORCE, &bufferSize, sizeof(bufferSize)) != 0) {
+        setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+    }
+
+    struct sockaddr_nl address = {};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = CN_IDX_PROC;
+    address.nl_pid = 0;
+    if (bind(sock, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 || !sendListen(true)) {
+        error = std::string("proc connector: ") + strerror(errno);
+        close(sock);
+        sock = -1;
+        return false;
+    }
+
+    int ackError = waitForAck();
+    if (ackError != 0) {
+        error = std::string("proc connector: ") + strerror(ackError);
+        close(sock);
+        sock = -1;
+        return false;
+    }
+    return true;
+}
+
+bool ProcConnector::isOpen() const {
+    return sock >= 0;
+}
+
+int ProcConnector::fd() const {
+    return sock;
+}
+
+bool ProcConnector::sendListen(bool listen) {
+    constexpr size_t messageSize = sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op);
+    alignas(struct nlmsghdr) char request[NLMSG_SPACE(messageSize)] = {};
+
+    auto* header = reinterpret_cast<struct nlmsghdr*>(request);
+    header->nlmsg_len = NLMSG_LENGTH(messageSize);
+    header->nlmsg_type = NLMSG_DONE;
+    header->nlmsg_pid = static_cast<__u32>(getpid());
+
+    auto* message = static_cast<struct cn_msg*>(NLMSG_DATA(header));
+    message->id.idx = CN_IDX_PROC;
+    message->id.val = CN_VAL_PROC;
+    message->len = sizeof(enum proc_cn_mcast_op);
+
+    enum proc_cn_mcast_op op = listen ? PROC_CN_MCAST_LISTEN : PROC_CN_MCAST_IGNORE;
+    memcpy(message->data, &op, sizeof(op));
+
+    return send(sock, request, header->nlmsg_len, 0) == static_cast<ssize_t>(header->nlmsg_len);
+}
+
+int ProcConnector::waitForAck() {
+    // the kernel answers PROC_CN_MCAST_LISTEN with a PROC_EVENT_NONE carrying the error code
+    struct pollfd pfd = {sock, POLLIN, 0};
+    alignas(struct nlmsghdr) char buffer[4096];
+    while (poll(&pfd, 1, ACK_TIMEOUT_MS) > 0) {
+        ssize_t length = recv(sock, buffer, sizeof(buffer), 0);
+        if (length < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return errno;
+        }
+        for (auto* header = reinterpret_cast<struct nlmsghdr*>(buffer); NLMSG_OK(header, length);
+             header = NLMSG_NEXT(header, length)) {
+            auto* message = static_cast<struct cn_msg*>(NLMSG_DATA(header));
+            auto* event = reinterpret_cast<struct proc_event*>(message->data);
+            if (event->what == proc_event::PROC_EVENT_NONE) {
+                return static_cast<int>(event->event_data.ack.err);
+            }
+        }
+    }
+    // no ack at all: older kernels stay silent, so treat the subscription as accepted
+    return 0;
+}
+
+bool ProcConnector::drain(std::vector<ProcEvent>& events) {
+    if (sock < 0) {
+        return false;
+    }
+
+    alignas(struct nlmsghdr) char buffer[16384];
+    while (true) {
+        ssize_t length = recv(sock, buffer, sizeof(buffer), 0);
+        if (length < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+            // ENOBUFS: the socket overflowed and events were lost
+            return false;
+        }
+
+        for (auto* header = reinterpret_cast<struct nlmsghdr*>(buffer); NLMSG_OK(header, length);
+             header = NLMSG_NEXT(header, length)) {
+            if (header->nlmsg_type == NLMSG_ERROR || header->nlmsg_type == NLMSG_NOOP) {
+                continue;
+            }
+            auto* message = static_cast<struct cn_msg*>(NLMSG_DATA(header));
+            if (message->id.idx != CN_IDX_PROC || message->id.val != CN_VAL_PROC) {
+                continue;
+            }
+            auto* event = reinterpret_cast<struct proc_event*>(message->data);
+
+            switch (event->what) {
+                case proc_event::PROC_EVENT_FORK:
+                    events.push_back({ProcEvent::Type::Fork, event->event_data.fork.child_pid,
+                                      event->event_data.fork.child_tgid, {}});
+                    break;
+                case proc_event::PROC_EVENT_EXEC:
+                    events.push_back({ProcEvent::Type::Exec, event->event_data.exec.process_pid,
+                                      event->event_data.exec.process_tgid, {}});
+                    break;
+                case proc_event::PROC_EVENT_COMM:
+                    events.push_back({ProcEvent::Type::Comm, event->event_data.comm.process_pid,
+                                      event->event_data.comm.process_tgid,
+                                      std::string(event->event_data.comm.comm,
+                                                  strnlen(event->event_data.comm.comm, sizeof(event->event_data.comm.comm)))});
+                    break;
+                case proc_event::PROC_EVENT_EXIT:
+                    events.push_back({ProcEvent::Type::Exit, event->event_data.exit.process_pid,
+                                      event->event_data.exit.process_tgid, {}});
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
@@ -0,0 +1,123 @@
+#include "../include/proc_file_cache.h"
+#include "../include/proc_io.h"
+#include <cerrno>
+
+ProcFileCache::ProcFileCache(size_t maxOpenFiles)
+    : generation(0), maxOpenFiles(maxOpenFiles), openFileCount(0) {}
+
+ProcFileCache::~ProcFileCache() {
+    for (auto& [pid, entry] : entries) {
+        closeEntry(entry);
+    }
+}
+
+void ProcFileCache::beginScan() {
+    ++generation;
+}
+
+std::optional<std::string_view> ProcFileCache::read(int pid, ProcFile file) {
+    auto [it, inserted] = entries.try_emplace(pid);
+    Entry& entry = it->second;
+    if (inserted) {
+        entry.fds.fill(NOT_OPENED);
+    }
+    entry.generation = generation;
+
+    int& fd = entry.fds[static_cast<size_t>(file)];
+    if (fd == UNAVAILABLE) {
+        return std::nullopt;
+    }
+
+    // a cached descriptor outlives its process, so a failed read may just mean the pid was reused
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (fd == NOT_OPENED) {
+            if (openFileCount >= maxOpenFiles) {
+                return readOnce(pid, file);
+            }
+            fd = openFile(pid, file);
+            if (fd == UNAVAILABLE) {
+                return std::nullopt;
+            }
+            if (fd == NOT_OPENED) {
+                return readOnce(pid, file);
+            }
+        }
+
+        auto content = readProcFile(fd, buffer);
+        if (content && !content->empty()) {
+            return content;
+        }
+
+        closeProcFile(fd);
+        fd = NOT_OPENED;
+        --openFileCount;
+    }
+
+    return std::nullopt;
+}
+
+void ProcFileCache::endScan() {
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.generation != generation) {
+            closeEntry(it->second);
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ProcFileCache::forget(int pid) {
+    auto it = entries.find(pid);
+    if (it != entries.end()) {
+        closeEntry(it->second);
+        entries.erase(it);
+    }
+}
+
+size_t ProcFileCache::size() const {
+    return entries.size();
+}
+
+size_t ProcFileCache::openFiles() const {
+    return openFileCount;
+}
+
+int ProcFileCache::openFile(int pid, ProcFile file) {
+    int fd = openProcFile(pathFor(pid, file));
+    if (fd >= 0) {
+        ++openFileCount;
+        return fd;
+    }
+    // out of descriptors: fall back to one-shot reads rather than failing the process
+    if (errno == EMFILE || errno == ENFILE) {
+        maxOpenFiles = openFileCount;
+        return NOT_OPENED;
+    }
+    return UNAVAILABLE;
+}
+
+std::optional<std::string_view> ProcFileCache::readOnce(int pid, ProcFile file) {
+    int fd = openProcFile(pathFor(pid, file));
+    if (fd < 0) {
+        return std::nullopt;
+    }
+    auto content = readProcFile(fd, buffer);
+    closeProcFile(fd);
+    return content;
+}
+
+void ProcFileCache::closeEntry(Entry& entry) {
+    for (int& fd : entry.fds) {
+        if (fd >= 0) {
+            closeProcFile(fd);
+            --openFileCount;
+        }
+        fd = NOT_OPENED;
+    }
+}
+
+std::string ProcFileCache::pathFor(int pid, ProcFile file) {
+    static const char* const names[] = {"/statm", "/io", "/stat"};
+    return "/proc/" + std::to_string(pid) + names[static_cast<size_t>(file)];
+}
@@ -0,0 +1,62 @@
+#include "../include/proc_io.h"
+#include "../include/self_stats.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+namespace {
+constexpr size_t INITIAL_BUFFER_SIZE = 4096;
+}
+
+int openProcFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        countFileOpen();
+    }
+    return fd;
+}
+
+void closeProcFile(int fd) {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+std::optional<std::string_view> readProcFile(int fd, std::string& buffer) {
+    if (buffer.size() < INITIAL_BUFFER_SIZE) {
+        buffer.resize(INITIAL_BUFFER_SIZE);
+    }
+
+    size_t total = 0;
+    while (true) {
+        ssize_t n = pread(fd, &buffer[total], buffer.size() - total, static_cast<off_t>(total));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return std::nullopt;
+        }
+        countRead(static_cast<size_t>(n));
+        if (n == 0) break;
+        total += static_cast<size_t>(n);
+        if (total == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+        }
+    }
+
+    return std::string_view(buffer.data(), total);
+}
+
+size_t raiseOpenFileLimit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        return 1024;
+    }
+    if (limit.rlim_cur < limit.rlim_max) {
+        struct rlimit raised = limit;
+        raised.rlim_cur = limit.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &raised) == 0) {
+            limit = raised;
+        }
+    }
+    return limit.rlim_cur == RLIM_INFINITY ? static_cast<size_t>(1) << 20 : static_cast<size_t>(limit.rlim_cur);
+}
@@ -0,0 +1,118 @@
+#include "../include/proc_parsers.h"
+#include <charconv>
+
+namespace {
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n';
+}
+
+void skipSpaces(std::string_view& input) {
+    size_t i = 0;
+    while (i < input.size() && isSpace(input[i])) ++i;
+    input.remove_prefix(i);
+}
+
+bool skipFields(std::string_view& input, int count) {
+    for (int i = 0; i < count; ++i) {
+        if (nextToken(input).empty()) return false;
+    }
+    return true;
+}
+
+}
+
+std::string_view nextToken(std::string_view& input) {
+    skipSpaces(input);
+    size_t end = 0;
+    while (end < input.size() && !isSpace(input[end])) ++end;
+    std::string_view token = input.substr(0, end);
+    input.remove_prefix(end);
+    return token;
+}
+
+std::string_view nextLine(std::string_view& input) {
+    size_t end = input.find('\n');
+    std::string_view line = input.substr(0, end);
+    input.remove_prefix(end == std::string_view::npos ? input.size() : end + 1);
+    return line;
+}
+
+bool parseUnsigned(std::string_view& input, unsigned long long& value) {
+    skipSpaces(input);
+    auto [ptr, ec] = std::from_chars(input.data(), input.data() + input.size(), value);
+    if (ec != std::errc()) return false;
+    input.remove_prefix(static_cast<size_t>(ptr - input.data()));
+    return true;
+}
+
+bool parseSigned(std::string_view& input, long long& value) {
+    skipSpaces(input);
+    auto [ptr, ec] = std::from_chars(input.data(), input.data() + input.size(), value);
+    if (ec != std::errc()) return false;
+    input.remove_prefix(static_cast<size_t>(ptr - input.data()));
+    return true;
+}
+
+bool parsePid(std::string_view text, int& pid) {
+    if (text.empty()) return false;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), pid);
+    return ec == std::errc() && ptr == text.data() + text.size();
+}
+
+bool parseProcStat(std::string_view content, ProcStat& stat) {
+    // comm may itself contain spaces and parentheses, so bracket it by the first '(' and last ')'
+    size_t open = content.find('(');
+    size_t close = content.rfind(')');
+    if (open == std::string_view::npos || close == std::string_view::npos || close < open) {
+        return false;
+    }
+    stat.comm = content.substr(open + 1, close - open - 1);
+
+    std::string_view rest = content.substr(close + 1);
+    std::string_view state = nextToken(rest);
+    if (state.empty()) return false;
+    stat.state = state[0];
+
+    long long ppid, numThreads;
+    unsigned long long utime, stime, startTime;
+    if (!parseSigned(rest, ppid)) return false;                // field 4
+    if (!skipFields(rest, 9)) return false;                    // fields 5-13
+    if (!parseUnsigned(rest, utime)) return false;             // field 14
+    if (!parseUnsigned(rest, stime)) return false;             // field 15
+    if (!skipFields(rest, 4)) return false;                    // fields 16-19
+    if (!parseSigned(rest, numThreads)) return false;          // field 20
+    if (!skipFields(rest, 1)) return false;                    // field 21
+    if (!parseUnsigned(rest, startTime)) return false;         // field 22
+
+    stat.ppid = static_cast<int>(ppid);
+    stat.utime = utime;
+    stat.stime = stime;
+    stat.numThreads = static_cast<long>(numThreads);
+    stat.startTime = startTime;
+    return true;
+}
+
+bool parseProcStatm(std::string_view content, ProcStatm& statm) {
+    return parseUnsigned(content, statm.size) &&
+           parseUnsigned(content, statm.resident) &&
+           parseUnsigned(content, statm.shared);
+}
+
+bool parseProcIo(std::string_view content, ProcIo& io) {
+    io = ProcIo{};
+    bool found = false;
+    while (!content.empty()) {
+        std::string_view line = nextLine(content);
+        std::string_view key = nextToken(line);
+        long long value;
+        if (!parseSigned(line, value)) continue;
+
+        if (key == "rchar:") io.readChars = value;
+        else if (key == "wchar:") io.writeChars = value;
+        else if (key == "read_bytes:") { io.readBytes = value; found = true; }
+        else if (key == "write_bytes:") io.writeBytes = value;
+        else if (key == "cancelled_write_bytes:") io.cancelledWriteBytes = value;
+    }
+    return found;
+}
@@ -0,0 +1,147 @@
+#include "../include/process_delta_table.h"
+
+namespace {
+constexpr int EMPTY = 0;
+constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+uint64_t mix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+}
+
+ProcessDeltaTable::ProcessDeltaTable(size_t maxMemoryBytes)
+    : count(0), mask(0), maxMemoryBytes(maxMemoryBytes), generation(0), evictions(0), rejectedInserts(0) {
+    size_t capacity = INITIAL_CAPACITY;
+    while (capacity > 1 && capacity * sizeof(Slot) > maxMemoryBytes) {
+        capacity /= 2;
+    }
+    slots.assign(capacity, Slot{});
+    mask = capacity - 1;
+}
+
+void ProcessDeltaTable::beginGeneration() {
+    // generation 0 is what empty slots carry, so skip it on wrap-around
+    if (++generation == 0) {
+        ++generation;
+    }
+}
+
+size_t ProcessDeltaTable::indexFor(int pid, unsigned long long startTime) const {
+    return mix((static_cast<uint64_t>(static_cast<uint32_t>(pid)) << 32) ^ startTime) & mask;
+}
+
+size_t ProcessDeltaTable::findSlot(int pid, unsigned long long startTime) const {
+    for (size_t index = indexFor(pid, startTime);; index = (index + 1) & mask) {
+        const Slot& slot = slots[index];
+        if (slot.pid == EMPTY) return NOT_FOUND;
+        if (slot.pid == pid && slot.startTime == startTime) return index;
+    }
+}
+
+ProcessDelta* ProcessDeltaTable::findOrInsert(int pid, unsigned long long startTime, bool& inserted) {
+    inserted = false;
+    size_t found = findSlot(pid, startTime);
+    if (found != NOT_FOUND) {
+        slots[found].generation = generation;
+        return &slots[found].value;
+    }
+
+    if (count + 1 > static_cast<size_t>(slots.size() * MAX_LOAD) && !grow()) {
+        ++rejectedInserts;
+        return nullptr;
+    }
+
+    size_t index = indexFor(pid, startTime);
+    while (slots[index].pid != EMPTY) {
+        index = (index + 1) & mask;
+    }
+    slots[index] = Slot{pid, generation, startTime, ProcessDelta{}};
+    ++count;
+    inserted = true;
+    return &slots[index].value;
+}
+
+ProcessDelta* ProcessDeltaTable::find(int pid, unsigned long long startTime, bool& seenThisGeneration) {
+    size_t found = findSlot(pid, startTime);
+    if (found == NOT_FOUND) {
+        seenThisGeneration = false;
+        return nullptr;
+    }
+    seenThisGeneration = slots[found].generation == generation;
+    return &slots[found].value;
+}
+
+void ProcessDeltaTable::erase(int pid, unsigned long long startTime) {
+    size_t found = findSlot(pid, startTime);
+    if (found != NOT_FOUND) {
+        removeAt(found);
+    }
+}
+
+void ProcessDeltaTable::evictStale() {
+    if (count == 0) {
+        return;
+    }
+
+    // start just past an empty slot so no cluster wraps around the starting point; deleting
+    // then only ever pulls entries from further ahead into the hole we are standing on
+    size_t start = 0;
+    while (slots[start].pid != EMPTY) {
+        start = (start + 1) & mask;
+    }
+
+    for (size_t step = 1; step <= slots.size(); ++step) {
+        size_t index = (start + step) & mask;
+        while (slots[index].pid != EMPTY && slots[index].generation != generation) {
+            removeAt(index);
+            ++evictions;
+        }
+    }
+}
+
+void ProcessDeltaTable::removeAt(size_t index) {
+    // backward-shift deletion keeps probe sequences intact without tombstones
+    size_t hole = index;
+    size_t next = (hole + 1) & mask;
+    while (slots[next].pid != EMPTY) {
+        size_t home = indexFor(slots[next].pid, slots[next].startTime);
+        // move the entry back unless its home lies cyclically in (hole, next]
+        bool movable = hole <= next ? (home <= hole || home > next) : (home <= hole && home > next);
+        if (movable) {
+            slots[hole] = slots[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    slots[hole] = Slot{};
+    --count;
+}
+
+bool ProcessDeltaTable::grow() {
+    size_t newCapacity = slots.size() * 2;
+    if (newCapacity * sizeof(Slot) > maxMemoryBytes) {
+        return false;
+    }
+
+    std::vector<Slot> old(newCapacity, Slot{});
+    old.swap(slots);
+    mask = newCapacity - 1;
+    for (const Slot& slot : old) {
+        if (slot.pid == EMPTY) continue;
+        size_t index = indexFor(slot.pid, slot.startTime);
+        while (slots[index].pid != EMPTY) {
+            index = (index + 1) & mask;
+        }
+        slots[index] = slot;
+    }
+    return true;
+}
+
+ProcessDeltaTable::Stats ProcessDeltaTable::stats() const {
+    return {count, slots.size(), slots.size() * sizeof(Slot), maxMemoryBytes, evictions, rejectedInserts};
+}
@@ -1,17 +1,68 @@
 #include "../include/process_monitor.h"
 #include <algorithm>
+#include <charconv>
 #include <sys/sysinfo.h>
 #include <unistd.h>
 #include <dirent.h>
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <cstring>
-#include <map>
 #include <filesystem>
+#include <unordered_map>
+#include "../include/proc_io.h"
+#include "../include/proc_parsers.h"
+#include "../include/self_stats.h"
 
-ProcessMonitor::ProcessMonitor() {
+ProcessMonitor::ProcessMonitor(const Config& config, std::shared_ptr<const MemorySampler> memory,
+                               std::shared_ptr<const PacketFlowMonitor> network)
+    : namePool(std::make_shared<StringPool>()), sortLimit(SORT_HEADROOM),
+      workerPool(static_cast<size_t>(std::max(config.getProcessScanThreads(), 1))), rescanNeeded(true),
+      pageSize(sysconf(_SC_PAGESIZE)), clockTicks(sysconf(_SC_CLK_TCK)), threadSampler(namePool, clockTicks),
+      configExpandedPids(config.getExpandedPids()), expandedPids(std::make_shared<const std::vector<int>>()),
+      memory(memory ? std::move(memory) : std::make_shared<MemorySampler>()), network(std::move(network)) {
     lastUpdateTime = std::chrono::steady_clock::now();
+
+    size_t shardCount = workerPool.size();
+    size_t fileBudget = raiseOpenFileLimit() / 2 / shardCount;
+    size_t deltaBudget = config.getProcessDeltaMaxBytes() / shardCount;
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards.push_back(std::make_unique<ScanShard>(fileBudget, deltaBudget));
+    }
+
+    if (config.getProcessCollector() == "taskstats") {
+        openTaskstats();
+    }
+
+    if (config.getProcessEventMode()) {
+        procConnector = std::make_unique<ProcConnector>();
+        std::string error;
+        if (!procConnector->open(error)) {
+            std::cerr << "Process event mode unavailable, falling back to /proc scans: " << error << std::endl;
+            procConnector.reset();
+        }
+    }
+
+    publish(takeSnapshotBuffer());
+}
+
+void ProcessMonitor::openTaskstats() {
+    std::string error;
+    for (auto& shard : shards) {
+        shard->taskstats = std::make_unique<TaskstatsClient>();
+        if (!shard->taskstats->open(error)) {
+            std::cerr << "Taskstats collector unavailable, falling back to /proc: " << error << std::endl;
+            for (auto& other : shards) {
+                other->taskstats.reset();
+            }
+            return;
+        }
+    }
+
+    taskstatsExits = std::make_unique<TaskstatsClient>();
+    if (!taskstatsExits->open(error) || !taskstatsExits->listenForExits(error)) {
+        std::cerr << "Taskstats exit listener unavailable: " << error << std::endl;
+        taskstatsExits.reset();
+    }
 }
 
 ProcessMonitor::~ProcessMonitor() {
@@ -20,121 +71,391 @@ ProcessMonitor::~ProcessMonitor() {
 
 void ProcessMonitor::update() {
     auto currentTime = std::chrono::steady_clock::now();
-    double elapsedSeconds = std::chrono::duration<double>(currentTime - lastUpdateTime).count();
-    
-    std::vector<ProcessInfo> newProcesses;
-    static std::map<int, unsigned long long> lastTotalTimes;
+    scanTime = currentTime;
+
+    for (auto& shard : shards) {
+        shard->pids.clear();
+        shard->exited.clear();
+    }
+
+    if (taskstatsExits) {
+        exitedSamples.clear();
+        taskstatsExits->drainExits(exitedSamples);
+        for (auto& sample : exitedSamples) {
+            shards[static_cast<size_t>(sample.pid) % shards.size()]->exited.push_back(std::move(sample));
+        }
+    }
+
+    if (procConnector) {
+        // the scan reads every name afresh, so held-back renames are moot
+        drainProcEvents();
+        pendingRenames.clear();
+    }
+
+    if (!procConnector || rescanNeeded) {
+        scanProcDirectory();
+    } else {
+        for (int pid : trackedPids) {
+            shards[static_cast<size_t>(pid) % shards.size()]->pids.push_back(pid);
+        }
+    }
+
+    // each shard gets a disjoint range of rows sized for its worst case, closed up afterwards
+    size_t rowCapacity = 0;
+    for (auto& shard : shards) {
+        shard->rowBase = rowCapacity;
+        shard->rowCount = 0;
+        rowCapacity += shard->pids.size() + shard->exited.size();
+    }
+    auto next = takeSnapshotBuffer();
+    ProcessTable& table = next->table;
+    table.resize(rowCapacity);
+
+    workerPool.parallelFor(shards.size(), [this, &table](size_t index) { scanShard(*shards[index], table); });
+
+    size_t rows = 0;
+    for (auto& shard : shards) {
+        table.moveRows(shard->rowBase, rows, shard->rowCount);
+        rows += shard->rowCount;
+        if (procConnector) {
+            for (int pid : shard->vanished) {
+                trackedPids.erase(pid);
+            }
+        }
+    }
+    table.resize(rows);
+
+    // memoryUsage is resident MB
+    double totalSystemMemory = static_cast<double>(memory->totalKb()) / 1024.0;
+    double cpuCount = static_cast<double>(sysconf(_SC_NPROCESSORS_ONLN));
+
+    for (size_t i = 0; i < rows; ++i) {
+        double cpuPercentage = table.cpuUsage[i] / cpuCount;
+        if (table.exited[i]) {
+            table.overallUsage[i] = static_cast<float>(cpuPercentage / 2.0);
+            continue;
+        }
+        double memoryPercentage = (totalSystemMemory > 0) ? (table.memoryUsage[i] / totalSystemMemory) * 100.0 : 0.0;
+        table.overallUsage[i] = static_cast<float>((cpuPercentage + memoryPercentage) / 2.0);
+    }
+
+    if (network) {
+        auto rates = network->getRates();
+        for (size_t i = 0; i < rows; ++i) {
+            auto it = rates->find(table.pid[i]);
+            if (it != rates->end()) {
+                table.networkReceive[i] = static_cast<float>(it->second.receiveBytesPerSec);
+                table.networkSend[i] = static_cast<float>(it->second.sendBytesPerSec);
+            }
+        }
+    }
+
+    next->order.resize(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        next->order[i] = static_cast<uint32_t>(i);
+    }
+    next->sortedCount = 0;
+    orderProcesses(*next, sortLimit.load(std::memory_order_relaxed));
+    next->deltaStats = getDeltaTableStats();
+
+    auto requested = std::atomic_load(&expandedPids);
+    threadPids.assign(configExpandedPids.begin(), configExpandedPids.end());
+    threadPids.insert(threadPids.end(), requested->begin(), requested->end());
+    std::sort(threadPids.begin(), threadPids.end());
+    threadPids.erase(std::unique(threadPids.begin(), threadPids.end()), threadPids.end());
+    threadSampler.sample(threadPids, currentTime, next->threads, next->threadGroups);
+
+    publish(std::move(next));
+    lastUpdateTime = currentTime;
+}
+
+std::shared_ptr<ProcessSnapshot> ProcessMonitor::takeSnapshotBuffer() {
+    // use_count() can only fall here: the snapshot is no longer published, so no reader can pick it up
+    if (spareSnapshot && spareSnapshot.use_count() == 1) {
+        // pairs with the release in the last reader's reference drop before its columns are reused
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return std::move(spareSnapshot);
+    }
+    auto fresh = std::make_shared<ProcessSnapshot>();
+    fresh->names = namePool;
+    fresh->table.hasDelays = shards.front()->taskstats != nullptr;
+    fresh->table.hasNetwork = network != nullptr;
+    return fresh;
+}
+
+void ProcessMonitor::publish(std::shared_ptr<ProcessSnapshot> next) {
+    std::atomic_store(&snapshot, std::shared_ptr<const ProcessSnapshot>(next));
+    spareSnapshot = std::move(lastPublished);
+    lastPublished = std::move(next);
+}
+
+std::shared_ptr<const ProcessSnapshot> ProcessMonitor::getProcesses(size_t visibleRows) {
+    size_t limit = visibleRows + SORT_HEADROOM;
+    sortLimit.store(limit, std::memory_order_relaxed);
+
+    auto current = std::atomic_load(&snapshot);
+    if (current->sortedCount < std::min(limit, current->size())) {
+        // scrolled past the ordered prefix: extend it in a copy instead of waiting for the next scan
+        auto extended = std::make_shared<ProcessSnapshot>(*current);
+        orderProcesses(*extended, limit);
+        std::shared_ptr<const ProcessSnapshot> published(std::move(extended));
+        // if a scan was published in the meantime it wins; this caller still gets its ordered copy
+        std::atomic_compare_exchange_strong(&snapshot, &current, published);
+        current = std::move(published);
+    }
+    return current;
+}
+
+std::shared_ptr<const ProcessSnapshot> ProcessMonitor::getSnapshot() const {
+    return std::atomic_load(&snapshot);
+}
+
+void ProcessMonitor::setExpandedPids(std::vector<int> pids) {
+    std::shared_ptr<const std::vector<int>> next = std::make_shared<const std::vector<int>>(std::move(pids));
+    std::atomic_store(&expandedPids, std::move(next));
+}
+
+void ProcessMonitor::orderProcesses(ProcessSnapshot& snapshot, size_t count) {
+    auto& order = snapshot.order;
+    count = std::min(count, order.size());
+    if (count <= snapshot.sortedCount) {
+        return;
+    }
+
+    const float* usage = snapshot.table.overallUsage.data();
+    auto byUsage = [usage](uint32_t a, uint32_t b) { return usage[a] > usage[b]; };
+    // everything past sortedCount ranks below the ordered prefix, so extending it only touches the tail
+    auto first = order.begin() + snapshot.sortedCount;
+    auto middle = order.begin() + count;
+    if (middle != order.end()) {
+        std::nth_element(first, middle, order.end(), byUsage);
+    }
+    std::sort(first, middle, byUsage);
+    snapshot.sortedCount = count;
+}
+
+ProcessDeltaTable::Stats ProcessMonitor::getDeltaTableStats() const {
+    ProcessDeltaTable::Stats total = {};
+    for (const auto& shard : shards) {
+        auto stats = shard->deltas.stats();
+        total.size += stats.size;
+        total.capacity += stats.capacity;
+        total.memoryBytes += stats.memoryBytes;
+        total.maxMemoryBytes += stats.maxMemoryBytes;
+        total.evictions += stats.evictions;
+        total.rejectedInserts += stats.rejectedInserts;
+    }
+    return total;
+}
+
+int ProcessMonitor::eventFd() const {
+    return procConnector ? procConnector->fd() : -1;
+}
+
+void ProcessMonitor::applyProcEvents() {
+    drainProcEvents();
+    auto now = std::chrono::steady_clock::now();
+    if (pendingRenames.empty() || now - lastRenamePublish < RENAME_PUBLISH_INTERVAL) {
+        return;
+    }
+
+    // most renamed pids are short-lived children no scan has listed, so copy the table only for a hit
+    auto published = std::atomic_load(&snapshot);
+    const ProcessTable& current = published->table;
+    renamedRows.clear();
+    for (size_t i = 0; i < current.size(); ++i) {
+        auto it = pendingRenames.find(current.pid[i]);
+        if (it != pendingRenames.end() && namePool->get(current.nameId[i]) != it->second) {
+            renamedRows.emplace_back(i, namePool->intern(it->second));
+        }
+    }
+    pendingRenames.clear();
+    if (renamedRows.empty()) {
+        return;
+    }
+
+    // published snapshots are immutable, so renames go out as a fresh copy
+    auto next = std::make_shared<ProcessSnapshot>(*published);
+    for (const auto& [row, nameId] : renamedRows) {
+        next->table.nameId[row] = nameId;
+    }
+    publish(std::move(next));
+    lastRenamePublish = now;
+}
 
+void ProcessMonitor::drainProcEvents() {
+    pendingEvents.clear();
+    if (!procConnector->drain(pendingEvents)) {
+        rescanNeeded = true;
+    }
+
+    for (const auto& event : pendingEvents) {
+        // thread-level events carry pid != tgid; only whole processes are tracked
+        if (event.pid != event.tgid) {
+            continue;
+        }
+        switch (event.type) {
+            case ProcEvent::Type::Fork:
+                trackedPids.insert(event.pid);
+                break;
+            case ProcEvent::Type::Exec: {
+                trackedPids.insert(event.pid);
+                char pid[16];
+                commPath.assign("/proc/");
+                commPath.append(pid, std::to_chars(pid, pid + sizeof(pid), event.pid).ptr);
+                commPath.append("/comm");
+                int fd = openProcFile(commPath);
+                if (fd < 0) {
+                    break;
+                }
+                if (auto comm = readProcFile(fd, commBuffer)) {
+                    std::string_view name = *comm;
+                    if (!name.empty() && name.back() == '\n') {
+                        name.remove_suffix(1);
+                    }
+                    pendingRenames[event.pid] = makeDisplayName(event.pid, name);
+                }
+                closeProcFile(fd);
+                break;
+            }
+            case ProcEvent::Type::Comm:
+                pendingRenames[event.pid] = makeDisplayName(event.pid, event.comm);
+                break;
+            case ProcEvent::Type::Exit:
+                trackedPids.erase(event.pid);
+                pendingRenames.erase(event.pid);
+                break;
+        }
+    }
+}
+
+void ProcessMonitor::scanProcDirectory() {
     DIR* proc_dir = opendir("/proc");
     if (proc_dir == nullptr) {
         std::cerr << "Failed to open /proc directory: " << strerror(errno) << std::endl;
         return;
     }
+    countFileOpen();
+
+    if (procConnector) {
+        trackedPids.clear();
+        rescanNeeded = false;
+    }
 
     struct dirent* entry;
     while ((entry = readdir(proc_dir)) != nullptr) {
         if (entry->d_type == DT_DIR) {
-            std::string filename(entry->d_name);
-            if (std::all_of(filename.begin(), filename.end(), ::isdigit)) {
-                int pid = std::stoi(filename);
-                try {
-                    ProcessInfo info = readProcessInfoFromProc(pid);
-                    info.cpuUsage = calculateCPUUsage(pid);
-                    newProcesses.push_back(info);
-                } catch (const std::exception& e) {
-                    // silently ignore error
+            int pid;
+            if (parsePid(entry->d_name, pid)) {
+                shards[static_cast<size_t>(pid) % shards.size()]->pids.push_back(pid);
+                if (procConnector) {
+                    trackedPids.insert(pid);
                 }
             }
         }
     }
 
     closedir(proc_dir);
+}
 
-    double totalSystemMemory = getTotalSystemMemory();
+void ProcessMonitor::scanShard(ScanShard& shard, ProcessTable& table) {
+    shard.vanished.clear();
+    shard.fileCache.beginScan();
+    shard.deltas.beginGeneration();
 
-    for (auto& process : newProcesses) {
-        double cpuPercentage = process.cpuUsage / sysconf(_SC_NPROCESSORS_ONLN);
-        double memoryPercentage = (totalSystemMemory > 0) ? (process.memoryUsage / totalSystemMemory) * 100.0 : 0.0;
-        process.overallUsage = (cpuPercentage + memoryPercentage) / 2.0;
+    if (shard.taskstats) {
+        shard.taskstats->query(shard.pids, shard.samples, shard.sampleValid);
     }
 
-    std::sort(newProcesses.begin(), newProcesses.end(),
-              [](const ProcessInfo& a, const ProcessInfo& b) { return a.overallUsage > b.overallUsage; });
+    for (size_t i = 0; i < shard.pids.size(); ++i) {
+        int pid = shard.pids[i];
+        try {
+            const TaskstatsSample* sample = nullptr;
+            if (shard.taskstats) {
+                sample = shard.sampleValid[i] ? &shard.samples[i] : nullptr;
+            }
+            ProcessInfo info;
+            if ((!shard.taskstats || sample) && readProcessInfoFromProc(shard, pid, sample, info)) {
+                table.setRow(shard.rowBase + shard.rowCount++, info);
+            } else {
+                shard.fileCache.forget(pid);
+                shard.vanished.push_back(pid);
+            }
+        } catch (const std::exception& e) {
+            // silently ignore error
+        }
+    }
 
-    processes = std::move(newProcesses);
-    lastUpdateTime = currentTime;
+    shard.fileCache.endScan();
+    addExitedProcesses(shard, table);
+    shard.deltas.evictStale();
 }
 
-std::vector<ProcessInfo> ProcessMonitor::getProcesses() const {
-    return processes;
+void ProcessMonitor::addExitedProcesses(ScanShard& shard, ProcessTable& table) {
+    for (const auto& sample : shard.exited) {
+        bool seenThisTick = false;
+        ProcessDelta* last = shard.deltas.find(sample.pid, sample.startTime, seenThisTick);
+        // still listed this tick (a zombie, or it exited after being read): the live row wins
+        if (seenThisTick) {
+            continue;
+        }
+
+        ProcessInfo info{};
+        info.pid = sample.pid;
+        info.nameId = last ? last->nameId : namePool->intern(makeDisplayName(sample.pid, sample.comm));
+        info.exited = true;
+        info.diskRead = static_cast<long long>(sample.readBytes);
+        info.diskWrite = static_cast<long long>(sample.writeBytes);
+
+        // without a previous sample the process lived entirely inside this tick
+        ProcessCounters previous = last ? last->counters : ProcessCounters{0, 0, 0, 0, lastUpdateTime};
+        computeRates(previous, {sample.cpuTimeUs, sample.cpuDelayNs, sample.blkioDelayNs, sample.swapinDelayNs, scanTime}, info);
+        if (last) {
+            shard.deltas.erase(sample.pid, sample.startTime);
+        }
+
+        table.setRow(shard.rowBase + shard.rowCount++, info);
+    }
 }
 
-ProcessInfo ProcessMonitor::readProcessInfoFromProc(int pid) {
-    ProcessInfo info;
+bool ProcessMonitor::readProcessInfoFromProc(ScanShard& shard, int pid, const TaskstatsSample* sample, ProcessInfo& info) {
+    info = ProcessInfo{};
     info.pid = pid;
 
     try {
-        std::string comm;
-        {
-            std::ifstream comm_file("/proc/" + std::to_string(pid) + "/comm");
-            std::getline(comm_file, comm);
-        }
-        
-        if (!comm.empty()) {
-            info.name = comm;
+        if (sample) {
+            applyDeltas(shard, pid, sample->startTime, sample->comm,
+                        {sample->cpuTimeUs, sample->cpuDelayNs, sample->blkioDelayNs, sample->swapinDelayNs, scanTime}, info);
         } else {
-            std::string cmdline;
-            {
-                std::ifstream cmdline_file("/proc/" + std::to_string(pid) + "/cmdline");
-                std::getline(cmdline_file, cmdline, '\0');
+            auto statContent = shard.fileCache.read(pid, ProcFile::Stat);
+            ProcStat stat;
+            if (!statContent || !parseProcStat(*statContent, stat)) {
+                return false;
             }
-            
-            if (!cmdline.empty()) {
-                std::filesystem::path p(cmdline.substr(0, cmdline.find(' ')));
-                info.name = p.filename().string();
-            } else {
-                info.name = "unknown";
-            }
-        }
 
-
-        info.name.erase(std::remove_if(info.name.begin(), info.name.end(), 
-                                       [](unsigned char c) { return !std::isprint(c); }),
-                        info.name.end());
-        if (info.name.length() > MAX_NAME_LENGTH) {
-            info.name = info.name.substr(0, TRUNCATE_LENGTH) + "...";
+            unsigned long long cpuTimeUs = (stat.utime + stat.stime) * 1000000ULL / static_cast<unsigned long long>(clockTicks);
+            applyDeltas(shard, pid, stat.startTime, stat.comm, {cpuTimeUs, 0, 0, 0, scanTime}, info);
         }
 
-        unsigned long long vm_size, vm_rss;
-        {
-            std::ifstream statm_file("/proc/" + std::to_string(pid) + "/statm");
-            statm_file >> vm_size >> vm_rss;
+        ProcStatm statm;
+        if (auto statmContent = shard.fileCache.read(pid, ProcFile::Statm); statmContent && parseProcStatm(*statmContent, statm)) {
+            info.memoryUsage = (statm.resident * pageSize) / (1024.0 * 1024.0);
         }
-        info.memoryUsage = (vm_rss * sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
 
-        {
-            std::ifstream io_file("/proc/" + std::to_string(pid) + "/io");
-            std::string line;
-            while (std::getline(io_file, line)) {
-                std::istringstream iss(line);
-                std::string key;
-                long long value;
-                if (iss >> key >> value) {
-                    if (key == "read_bytes:") info.diskRead = value;
-                    else if (key == "write_bytes:") info.diskWrite = value;
-                }
-            }
+        // taskstats only reports I/O per thread, so the thread-group totals still come from procfs
+        ProcIo io;
+        if (auto ioContent = shard.fileCache.read(pid, ProcFile::Io); ioContent && parseProcIo(*ioContent, io)) {
+            info.diskRead = io.readBytes;
+            info.diskWrite = io.writeBytes;
         }
 
-        info.cpuUsage = calculateCPUUsage(pid);
-
         info.overallUsage = CPU_WEIGHT * info.cpuUsage + 
                             MEMORY_WEIGHT * info.memoryUsage + 
                             DISK_WEIGHT * ((info.diskRead + info.diskWrite) / (1024.0 * 1024.0));
 
     } catch (const std::exception& e) {
         std::cerr << "Error reading info for PID " << pid << ": " << e.what() << std::endl;
-        info.name = "error";
+        info.nameId = namePool->intern("error");
         info.memoryUsage = 0;
         info.diskRead = 0;
         info.diskWrite = 0;
@@ -142,57 +463,167 @@ ProcessInfo ProcessMonitor::readProcessInfoFromProc(int pid) {
         info.overallUsage = 0;
     }
 
-    return info;
+    return true;
 }
 
-double ProcessMonitor::getTotalSystemMemory() {
-    std::ifstream meminfo("/proc/meminfo");
-    std::string line;
-    while (std::getline(meminfo, line)) {
-        if (line.compare(0, 9, "MemTotal:") == 0) {
-            long long memTotal;
-            std::istringstream iss(line);
-            std::string dummy;
-            iss >> dummy >> memTotal;
-            return memTotal * 1024.0; 
+std::string ProcessMonitor::makeDisplayName(int pid, std::string_view comm) const {
+    std::string name;
+    if (!comm.empty()) {
+        name = std::string(comm);
+    } else {
+        std::string cmdline;
+        {
+            std::ifstream cmdline_file("/proc/" + std::to_string(pid) + "/cmdline");
+            std::getline(cmdline_file, cmdline, '\0');
         }
+        
+        if (!cmdline.empty()) {
+            std::filesystem::path p(cmdline.substr(0, cmdline.find(' ')));
+            name = p.filename().string();
+        } else {
+            name = "unknown";
+        }
+    }
+
+    name.erase(std::remove_if(name.begin(), name.end(), 
+                              [](unsigned char c) { return !std::isprint(c); }),
+               name.end());
+    if (name.length() > MAX_NAME_LENGTH) {
+        name = name.substr(0, TRUNCATE_LENGTH) + "...";
     }
-    return 0.0;
+    return name;
 }
 
-double ProcessMonitor::calculateCPUUsage(int pid) {
-    static std::map<int, std::pair<unsigned long long, std::chrono::steady_clock::time_point>> lastValues;
+void ProcessMonitor::applyDeltas(ScanShard& shard, int pid, unsigned long long startTime, std::string_view comm,
+                                 const ProcessCounters& current, ProcessInfo& info) {
+    bool inserted = false;
+    ProcessDelta* last = shard.deltas.findOrInsert(pid, startTime, inserted);
+    if (!last) {
+        // table is at its memory cap; the process is listed but without rates or a cached name
+        info.nameId = namePool->intern(makeDisplayName(pid, comm));
+        return;
+    }
 
-    try {
-        std::ifstream stat_file("/proc/" + std::to_string(pid) + "/stat");
-        std::string line;
-        std::getline(stat_file, line);
-        std::istringstream iss(line);
-
-        std::string unused;
-        unsigned long long utime, stime;
-        for (int i = 1; i <= 13; ++i) iss >> unused;
-        iss >> utime >> stime;
-
-        unsigned long long total_time = utime + stime;
-        auto current_time = std::chrono::steady_clock::now();
-
-        double cpu_usage = 0.0;
-        if (lastValues.find(pid) != lastValues.end()) {
-            const auto& [last_total_time, last_time] = lastValues[pid];
-            auto time_diff = std::chrono::duration_cast<std::chrono::milliseconds>(current_time - last_time).count();
-            
-            if (time_diff > 0) {
-                unsigned long long time_diff_total = total_time - last_total_time;
-                cpu_usage = (time_diff_total * 1000.0 / (sysconf(_SC_CLK_TCK) * time_diff)) * 100.0;
-            }
-        }
+    if (!inserted) {
+        computeRates(last->counters, current, info);
+    }
+    info.nameId = cachedName(*last, inserted, pid, comm);
+    last->counters = current;
+}
 
-        lastValues[pid] = {total_time, current_time};
-        return cpu_usage;
+uint32_t ProcessMonitor::cachedName(ProcessDelta& entry, bool fresh, int pid, std::string_view comm) {
+    size_t commHash = std::hash<std::string_view>()(comm);
+    if (fresh || commHash != entry.commHash) {
+        entry.nameId = namePool->intern(makeDisplayName(pid, comm));
+        entry.commHash = commHash;
+    }
+    return entry.nameId;
+}
 
-    } catch (const std::exception& e) {
-        std::cerr << "Error calculating CPU usage for PID " << pid << ": " << e.what() << std::endl;
-        return 0.0;
+void ProcessMonitor::computeRates(const ProcessCounters& last, const ProcessCounters& current, ProcessInfo& info) {
+    double elapsedUs = std::chrono::duration<double, std::micro>(current.time - last.time).count();
+    
+    if (elapsedUs > 0) {
+        info.cpuUsage = (current.cpuTimeUs - last.cpuTimeUs) / elapsedUs * 100.0;
+        // ns of delay per us of wall time is numerically ms per second
+        info.cpuDelay = (current.cpuDelayNs - last.cpuDelayNs) / elapsedUs;
+        info.blkioDelay = (current.blkioDelayNs - last.blkioDelayNs) / elapsedUs;
+        info.swapinDelay = (current.swapinDelayNs - last.swapinDelayNs) / elapsedUs;
+    }
+}
+
+void ProcessTable::resize(size_t rows) {
+    pid.resize(rows);
+    nameId.resize(rows);
+    cpuUsage.resize(rows);
+    memoryUsage.resize(rows);
+    diskRead.resize(rows);
+    diskWrite.resize(rows);
+    overallUsage.resize(rows);
+    exited.resize(rows);
+    if (hasDelays) {
+        cpuDelay.resize(rows);
+        blkioDelay.resize(rows);
+        swapinDelay.resize(rows);
+    }
+    if (hasNetwork) {
+        networkReceive.resize(rows);
+        networkSend.resize(rows);
+    }
+}
+
+void ProcessTable::setRow(size_t row, const ProcessInfo& info) {
+    pid[row] = info.pid;
+    nameId[row] = info.nameId;
+    cpuUsage[row] = static_cast<float>(info.cpuUsage);
+    memoryUsage[row] = static_cast<float>(info.memoryUsage);
+    diskRead[row] = info.diskRead;
+    diskWrite[row] = info.diskWrite;
+    overallUsage[row] = static_cast<float>(info.overallUsage);
+    exited[row] = info.exited;
+    if (hasDelays) {
+        cpuDelay[row] = static_cast<float>(info.cpuDelay);
+        blkioDelay[row] = static_cast<float>(info.blkioDelay);
+        swapinDelay[row] = static_cast<float>(info.swapinDelay);
+    }
+    if (hasNetwork) {
+        networkReceive[row] = static_cast<float>(info.networkReceive);
+        networkSend[row] = static_cast<float>(info.networkSend);
+    }
+}
+
+ProcessInfo ProcessTable::row(size_t row) const {
+    ProcessInfo info{pid[row], nameId[row], cpuUsage[row], memoryUsage[row], diskRead[row], diskWrite[row],
+                     overallUsage[row], 0, 0, 0, 0, 0, exited[row] != 0};
+    if (hasDelays) {
+        info.cpuDelay = cpuDelay[row];
+        info.blkioDelay = blkioDelay[row];
+        info.swapinDelay = swapinDelay[row];
+    }
+    if (hasNetwork) {
+        info.networkReceive = networkReceive[row];
+        info.networkSend = networkSend[row];
+    }
+    return info;
+}
+
+void ProcessTable::moveRows(size_t from, size_t to, size_t count) {
+    if (from == to || count == 0) {
+        return;
+    }
+    auto move = [from, to, count](auto& column) {
+        std::copy(column.begin() + from, column.begin() + from + count, column.begin() + to);
+    };
+    move(pid);
+    move(nameId);
+    move(cpuUsage);
+    move(memoryUsage);
+    move(diskRead);
+    move(diskWrite);
+    move(overallUsage);
+    move(exited);
+    if (hasDelays) {
+        move(cpuDelay);
+        move(blkioDelay);
+        move(swapinDelay);
+    }
+    if (hasNetwork) {
+        move(networkReceive);
+        move(networkSend);
+    }
+}
+
+size_t ProcessTable::memoryBytes() const {
+    auto bytes = [](const auto& column) { return column.capacity() * sizeof(column[0]); };
+    return bytes(pid) + bytes(nameId) + bytes(cpuUsage) + bytes(memoryUsage) + bytes(diskRead) + bytes(diskWrite) +
+           bytes(overallUsage) + bytes(cpuDelay) + bytes(blkioDelay) + bytes(swapinDelay) + bytes(networkReceive) + bytes(networkSend) + bytes(exited);
+}
+
+const ThreadGroup* ProcessSnapshot::threadsOf(int pid) const {
+    for (const auto& group : threadGroups) {
+        if (group.pid == pid) {
+            return &group;
+        }
     }
-}
\ No newline at end of file
+    return nullptr;
+}
@@ -1,8 +1,11 @@
 #include "../include/process_monitor_thread.h"
 #include <chrono>
+#include <poll.h>
 
-ProcessMonitorThread::ProcessMonitorThread(int updateInterval)
-    : running(false), updateInterval(updateInterval) {}
+ProcessMonitorThread::ProcessMonitorThread(const Config& config, std::shared_ptr<const MemorySampler> memory,
+                                           SelfStats& stats, std::shared_ptr<const PacketFlowMonitor> network)
+    : processMonitor(config, std::move(memory), std::move(network)), scanStat(stats.get("processes")),
+      eventStat(stats.get("process events")), running(false), updateInterval(config.getUpdateIntervalMs()) {}
 
 ProcessMonitorThread::~ProcessMonitorThread() {
     stop();
@@ -20,17 +23,49 @@ void ProcessMonitorThread::stop() {
     }
 }
 
-std::vector<ProcessInfo> ProcessMonitorThread::getProcesses() const {
-    std::lock_guard<std::mutex> lock(processesMutex);
-    return processMonitor.getProcesses();
+// Readers only ever touch the published snapshot, so neither call waits for a scan in progress.
+std::shared_ptr<const ProcessSnapshot> ProcessMonitorThread::getProcesses(size_t visibleRows) const {
+    return processMonitor.getProcesses(visibleRows);
+}
+
+ProcessDeltaTable::Stats ProcessMonitorThread::getDeltaTableStats() const {
+    return processMonitor.getSnapshot()->deltaStats;
+}
+
+void ProcessMonitorThread::setExpandedPids(const std::vector<int>& pids) const {
+    processMonitor.setExpandedPids(pids);
 }
 
 void ProcessMonitorThread::run() {
+    auto due = std::chrono::steady_clock::now();
     while (running) {
         {
-            std::lock_guard<std::mutex> lock(processesMutex);
+            SelfStatScope scope(scanStat, due);
             processMonitor.update();
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(updateInterval));
+        due = waitForNextUpdate();
+    }
+}
+
+std::chrono::steady_clock::time_point ProcessMonitorThread::waitForNextUpdate() {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(updateInterval);
+    int eventFd = processMonitor.eventFd();
+    if (eventFd < 0) {
+        std::this_thread::sleep_until(deadline);
+        return deadline;
+    }
+
+    // in event mode, apply exec/comm renames as they arrive instead of at the next scan
+    while (running) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            break;
+        }
+        struct pollfd pfd = {eventFd, POLLIN, 0};
+        if (poll(&pfd, 1, static_cast<int>(remaining.count())) > 0) {
+            SelfStatScope scope(eventStat);
+            processMonitor.applyProcEvents();
+        }
     }
+    return deadline;
 }
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "../include/self_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+std::string formatMicros(uint64_t nanoseconds) {
+    char text[32];
+    snprintf(text, sizeof(text), "%.1f", static_cast<double>(nanoseconds) / 1000.0);
+    return text;
+}
+
+}
+
+LatencyHistogram::LatencyHistogram() : total(0), sum(0), largest(0) {
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::record(uint64_t nanoseconds) {
+    buckets[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+    uint64_t seen = largest.load(std::memory_order_relaxed);
+    while (nanoseconds > seen && !largest.compare_exchange_weak(seen, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t LatencyHistogram::count() const {
+    return total.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::max() const {
+    return largest.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const {
+    uint64_t n = count();
+    return n == 0 ? 0.0 : static_cast<double>(sum.load(std::memory_order_relaxed)) / static_cast<double>(n);
+}
+
+uint64_t LatencyHistogram::quantile(double q) const {
+    uint64_t n = count();
+    if (n == 0) {
+        return 0;
+    }
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(n))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(bucketUpperEdge(i), max());
+        }
+    }
+    return max();
+}
+
+size_t LatencyHistogram::bucketOf(uint64_t value) {
+    value = std::min<uint64_t>(value, (uint64_t(1) << (MAX_EXPONENT + 1)) - 1);
+    if (value < (uint64_t(1) << SUB_BUCKET_BITS)) {
+        return static_cast<size_t>(value);
+    }
+    unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(value));
+    unsigned shift = exponent - SUB_BUCKET_BITS;
+    size_t sub = static_cast<size_t>(value >> shift) & ((size_t(1) << SUB_BUCKET_BITS) - 1);
+    return (static_cast<size_t>(exponent - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + sub;
+}
+
+uint64_t LatencyHistogram::bucketUpperEdge(size_t bucket) {
+    if (bucket < (size_t(1) << SUB_BUCKET_BITS)) {
+        return bucket;
+    }
+    unsigned shift = static_cast<unsigned>(bucket >> SUB_BUCKET_BITS) - 1;
+    uint64_t sub = bucket & ((size_t(1) << SUB_BUCKET_BITS) - 1);
+    uint64_t lower = ((uint64_t(1) << SUB_BUCKET_BITS) + sub) << shift;
+    return lower + (uint64_t(1) << shift) - 1;
+}
+
+SelfStat& SelfStats::get(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = byName.find(name);
+    if (it != byName.end()) {
+        return *it->second;
+    }
+    stats.emplace_back(name);
+    byName.emplace(name, &stats.back());
+    return stats.back();
+}
+
+std::vector<const SelfStat*> SelfStats::all() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<const SelfStat*> result;
+    result.reserve(stats.size());
+    for (const auto& stat : stats) {
+        result.push_back(&stat);
+    }
+    return result;
+}
+
+std::string SelfStats::report() const {
+    std::string out = "name                    runs    p50us    p99us    maxus  jit99us  opens/run  reads/run   KB/run\n";
+    char line[256];
+    for (const SelfStat* stat : all()) {
+        uint64_t runs = stat->latency.count();
+        double perRun = runs == 0 ? 0.0 : 1.0 / static_cast<double>(runs);
+        snprintf(line, sizeof(line), "%-20s %7llu %8s %8s %8s %8s %10.1f %10.1f %8.1f\n", stat->name.c_str(),
+                 static_cast<unsigned long long>(runs), formatMicros(stat->latency.quantile(0.5)).c_str(),
+                 formatMicros(stat->latency.quantile(0.99)).c_str(), formatMicros(stat->latency.max()).c_str(),
+                 stat->jitter.count() == 0 ? "-" : formatMicros(stat->jitter.quantile(0.99)).c_str(),
+                 stat->io.opens.load(std::memory_order_relaxed) * perRun,
+                 stat->io.reads.load(std::memory_order_relaxed) * perRun,
+                 stat->io.bytesRead.load(std::memory_order_relaxed) * perRun / 1024.0);
+        out += line;
+    }
+    return out;
+}
+
+SelfStatScope::SelfStatScope(SelfStat& stat)
+    : stat(stat), previous(currentIoTally), start(std::chrono::steady_clock::now()) {
+    currentIoTally = &stat.io;
+}
+
+SelfStatScope::SelfStatScope(SelfStat& stat, std::chrono::steady_clock::time_point scheduled) : SelfStatScope(stat) {
+    auto late = std::chrono::duration_cast<std::chrono::nanoseconds>(start - scheduled).count();
+    stat.jitter.record(late > 0 ? static_cast<uint64_t>(late) : 0);
+}
+
+SelfStatScope::~SelfStatScope() {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    stat.latency.record(static_cast<uint64_t>(elapsed.count()));
+    currentIoTally = previous;
+}
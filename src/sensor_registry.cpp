@@ -0,0 +1,336 @@
+#include "../include/sensor_registry.h"
+#include "../include/proc_io.h"
+#include "../include/proc_parsers.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+std::string readSysfsLine(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+// hwmon10 must sort after hwmon9
+std::vector<std::string> listNumbered(const std::string& directory, const std::string& prefix) {
+    std::vector<std::string> names;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+        std::string name = entry.path().filename();
+        if (name.compare(0, prefix.size(), prefix) == 0) {
+            names.push_back(name);
+        }
+    }
+    std::sort(names.begin(), names.end(), [](const std::string& a, const std::string& b) {
+        return a.size() != b.size() ? a.size() < b.size() : a < b;
+    });
+    return names;
+}
+
+// Calls fn(label, inputPath) for each temp<N>_input, with an empty label where the driver has none.
+template<typename Fn>
+void forEachTemperatureInput(const std::string& hwmonDir, Fn fn) {
+    for (const auto& name : listNumbered(hwmonDir, "temp")) {
+        const std::string suffix = "_input";
+        if (name.size() <= suffix.size() || name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+            continue;
+        }
+        std::string stem = name.substr(0, name.size() - suffix.size());
+        fn(readSysfsLine(hwmonDir + "/" + stem + "_label"), hwmonDir + "/" + name);
+    }
+}
+
+bool parseTrailingNumber(const std::string& text, int& value) {
+    size_t digits = text.find_last_not_of("0123456789");
+    digits = digits == std::string::npos ? 0 : digits + 1;
+    return parsePid(std::string_view(text).substr(digits), value);
+}
+
+bool isHotplugEvent(std::string_view message) {
+    std::string_view action, subsystem;
+    while (!message.empty()) {
+        size_t end = message.find('\0');
+        std::string_view field = message.substr(0, end);
+        if (field.compare(0, 7, "ACTION=") == 0) action = field.substr(7);
+        else if (field.compare(0, 10, "SUBSYSTEM=") == 0) subsystem = field.substr(10);
+        if (end == std::string_view::npos) break;
+        message.remove_prefix(end + 1);
+    }
+    if (action != "add" && action != "remove" && action != "online" && action != "offline") {
+        return false;
+    }
+    return subsystem == "cpu" || subsystem == "hwmon" || subsystem == "nvme" || subsystem == "thermal";
+}
+
+}
+
+SensorRegistry::SensorRegistry(std::string sysfsRoot)
+    : sysfsRoot(std::move(sysfsRoot)), rediscoverPending(true), discoveredOnlineCount(0), discoveries(0) {
+    // without the uevent socket (e.g. not permitted in a container) hotplug is still noticed
+    // through the online CPU count and through reads failing with ENODEV
+    std::string error;
+    uevents.open(NETLINK_KOBJECT_UEVENT, 1, error);
+}
+
+SensorRegistry::~SensorRegistry() {
+    closeAll();
+}
+
+void SensorRegistry::update(const std::vector<CpuBreakdown>& cores) {
+    if (drainUevents()) {
+        rediscoverPending = true;
+    }
+    size_t online = static_cast<size_t>(std::count_if(cores.begin(), cores.end(),
+                                                      [](const CpuBreakdown& core) { return core.online; }));
+    if (rediscoverPending || online != discoveredOnlineCount || cores.size() != cpuSensors.size()) {
+        discover(cores);
+    }
+
+    for (size_t i = 0; i < sensorList.size(); ++i) {
+        auto& sensor = sensorList[i];
+        auto content = readProcFile(sensorFds[i], buffer);
+        long long milliCelsius;
+        std::string_view rest = content ? *content : std::string_view();
+        if (!content || !parseSigned(rest, milliCelsius)) {
+            // a removed device answers ENODEV; other errors (a sleeping drive, a flaky
+            // sensor) just leave the reading out for this tick
+            if (!content && errno == ENODEV) {
+                rediscoverPending = true;
+            }
+            sensor.valid = false;
+            continue;
+        }
+        sensor.celsius = static_cast<double>(milliCelsius) / 1000.0;
+        sensor.valid = true;
+    }
+
+    for (size_t cpu = 0; cpu < frequencyFds.size(); ++cpu) {
+        frequencies[cpu] = 0;
+        if (frequencyFds[cpu] < 0 || !cores[cpu].online) {
+            continue;
+        }
+        auto content = readProcFile(frequencyFds[cpu], buffer);
+        unsigned long long kHz;
+        std::string_view rest = content ? *content : std::string_view();
+        if (content && parseUnsigned(rest, kHz)) {
+            frequencies[cpu] = static_cast<double>(kHz) / 1000000.0;
+        }
+    }
+}
+
+std::optional<double> SensorRegistry::coreTemperature(size_t cpu) const {
+    if (cpu >= cpuSensors.size() || cpuSensors[cpu] < 0) {
+        return std::nullopt;
+    }
+    const auto& sensor = sensorList[static_cast<size_t>(cpuSensors[cpu])];
+    if (!sensor.valid) {
+        return std::nullopt;
+    }
+    return sensor.celsius;
+}
+
+std::optional<double> SensorRegistry::coreFrequency(size_t cpu) const {
+    if (cpu >= frequencies.size() || frequencies[cpu] <= 0) {
+        return std::nullopt;
+    }
+    return frequencies[cpu];
+}
+
+const std::vector<TemperatureSensor>& SensorRegistry::sensors() const {
+    return sensorList;
+}
+
+size_t SensorRegistry::discoveryCount() const {
+    return discoveries;
+}
+
+void SensorRegistry::discover(const std::vector<CpuBreakdown>& cores) {
+    closeAll();
+
+    struct CoreSensor {
+        int package;
+        int core;
+        int sensor;
+    };
+    std::vector<CoreSensor> coreSensors;
+    std::vector<std::pair<int, int>> packageSensors;
+    // an input that fails to open is left out, so the thermal-zone fallback still runs when
+    // none of the hwmon ones did
+    auto addPackageSensor = [&](int package, std::string label, const std::string& input) {
+        int sensor = addSensor(SensorKind::Package, std::move(label), input);
+        if (sensor >= 0) {
+            packageSensors.emplace_back(package, sensor);
+        }
+    };
+
+    const std::string hwmonRoot = sysfsRoot + "/class/hwmon";
+    int amdPackage = 0;
+    for (const auto& hwmon : listNumbered(hwmonRoot, "hwmon")) {
+        const std::string dir = hwmonRoot + "/" + hwmon;
+        const std::string name = readSysfsLine(dir + "/name");
+
+        if (name == "coretemp") {
+            // one coretemp device per package; "Core N" is the physical core id within it
+            int package = -1;
+            std::string packageInput;
+            std::vector<std::pair<int, std::string>> coreInputs;
+            forEachTemperatureInput(dir, [&](const std::string& label, const std::string& input) {
+                int number;
+                if (label.compare(0, 11, "Package id ") == 0 && parseTrailingNumber(label, number)) {
+                    package = number;
+                    packageInput = input;
+                } else if (label.compare(0, 5, "Core ") == 0 && parseTrailingNumber(label, number)) {
+                    coreInputs.emplace_back(number, input);
+                }
+            });
+            if (package < 0) {
+                std::error_code ec;
+                auto device = std::filesystem::canonical(dir + "/device", ec).filename().string();
+                if (ec || !parseTrailingNumber(device, package)) {
+                    package = 0;
+                }
+            }
+            if (!packageInput.empty()) {
+                addPackageSensor(package, "Package id " + std::to_string(package), packageInput);
+            }
+            for (const auto& [core, input] : coreInputs) {
+                std::string label = "Core " + std::to_string(core);
+                if (package > 0) {
+                    label = "Package " + std::to_string(package) + " " + label;
+                }
+                int sensor = addSensor(SensorKind::Core, label, input);
+                if (sensor >= 0) {
+                    coreSensors.push_back({package, core, sensor});
+                }
+            }
+        } else if (name == "k10temp" || name == "zenpower") {
+            // AMD exposes die temperature only; Tctl carries a fan-curve offset on some parts, so Tdie wins
+            std::string tctl, tdie;
+            forEachTemperatureInput(dir, [&](const std::string& label, const std::string& input) {
+                if (label == "Tdie") tdie = input;
+                else if (label == "Tctl" || (label.empty() && tctl.empty())) tctl = input;
+            });
+            const std::string& input = tdie.empty() ? tctl : tdie;
+            if (!input.empty()) {
+                addPackageSensor(amdPackage, "Package id " + std::to_string(amdPackage), input);
+                ++amdPackage;
+            }
+        } else if (name == "nvme") {
+            std::error_code ec;
+            auto device = std::filesystem::canonical(dir + "/device", ec).filename().string();
+            if (ec) {
+                device = hwmon;
+            }
+            std::string composite;
+            forEachTemperatureInput(dir, [&](const std::string& label, const std::string& input) {
+                if (label == "Composite" || (label.empty() && composite.empty())) composite = input;
+            });
+            if (!composite.empty()) {
+                addSensor(SensorKind::Nvme, device, composite);
+            }
+        }
+    }
+
+    if (coreSensors.empty() && packageSensors.empty()) {
+        // no hwmon CPU driver (ARM boards, some VMs): fall back to CPU thermal zones
+        const std::string thermalRoot = sysfsRoot + "/class/thermal";
+        for (const auto& zone : listNumbered(thermalRoot, "thermal_zone")) {
+            const std::string dir = thermalRoot + "/" + zone;
+            const std::string type = readSysfsLine(dir + "/type");
+            if (type == "x86_pkg_temp" || type.find("cpu") != std::string::npos) {
+                addPackageSensor(static_cast<int>(packageSensors.size()), type, dir + "/temp");
+            }
+        }
+    }
+
+    const std::string cpuRoot = sysfsRoot + "/devices/system/cpu/cpu";
+    cpuSensors.assign(cores.size(), -1);
+    frequencyFds.assign(cores.size(), -1);
+    frequencies.assign(cores.size(), 0);
+    discoveredOnlineCount = 0;
+    for (size_t cpu = 0; cpu < cores.size(); ++cpu) {
+        // an offline CPU has no topology or cpufreq; it is mapped when its online uevent arrives
+        if (!cores[cpu].online) {
+            continue;
+        }
+        ++discoveredOnlineCount;
+        const std::string dir = cpuRoot + std::to_string(cpu);
+        frequencyFds[cpu] = openProcFile(dir + "/cpufreq/scaling_cur_freq");
+
+        int package, core;
+        if (!parsePid(readSysfsLine(dir + "/topology/physical_package_id"), package)) package = 0;
+        if (!parsePid(readSysfsLine(dir + "/topology/core_id"), core)) core = static_cast<int>(cpu);
+        for (const auto& entry : coreSensors) {
+            if (entry.package == package && entry.core == core) {
+                cpuSensors[cpu] = entry.sensor;
+                break;
+            }
+        }
+        if (cpuSensors[cpu] >= 0) {
+            continue;
+        }
+        for (const auto& [sensorPackage, sensor] : packageSensors) {
+            if (sensorPackage == package || packageSensors.size() == 1) {
+                cpuSensors[cpu] = sensor;
+                break;
+            }
+        }
+    }
+
+    rediscoverPending = false;
+    ++discoveries;
+}
+
+void SensorRegistry::closeAll() {
+    for (int fd : sensorFds) {
+        closeProcFile(fd);
+    }
+    for (int fd : frequencyFds) {
+        closeProcFile(fd);
+    }
+    sensorFds.clear();
+    sensorList.clear();
+    frequencyFds.clear();
+}
+
+bool SensorRegistry::drainUevents() {
+    if (!uevents.isOpen()) {
+        return false;
+    }
+    // every uevent on the system lands here, so the queue is emptied each tick even when
+    // the first message already settles it
+    bool hotplug = false;
+    while (true) {
+        ssize_t length = uevents.receive(ueventBuffer, false);
+        if (length == 0) {
+            break;
+        }
+        if (length < 0) {
+            // an overrun means events were dropped, one of which may have mattered
+            if (errno == ENOBUFS) {
+                hotplug = true;
+                continue;
+            }
+            break;
+        }
+        if (!hotplug && isHotplugEvent(std::string_view(ueventBuffer.data(), static_cast<size_t>(length)))) {
+            hotplug = true;
+        }
+    }
+    return hotplug;
+}
+
+int SensorRegistry::addSensor(SensorKind kind, std::string label, const std::string& inputPath) {
+    int fd = openProcFile(inputPath);
+    if (fd < 0) {
+        return -1;
+    }
+    sensorList.push_back({kind, std::move(label), 0, false});
+    sensorFds.push_back(fd);
+    return static_cast<int>(sensorList.size() - 1);
+}
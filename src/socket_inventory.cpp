@@ -0,0 +1,231 @@
+#include "../include/socket_inventory.h"
+#include "../include/proc_io.h"
+#include "../include/proc_parsers.h"
+#include "../include/self_stats.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <linux/sock_diag.h>
+
+namespace {
+
+constexpr int FAMILIES[] = {AF_INET, AF_INET6};
+constexpr size_t FAMILY_COUNT = sizeof(FAMILIES) / sizeof(FAMILIES[0]);
+
+// state 12 is TCP_NEW_SYN_RECV, which <netinet/tcp.h> does not name
+constexpr uint32_t DUMP_STATES = ~((1U << TCP_TIME_WAIT) | (1U << 12));
+
+}
+
+bool dumpInetSockets(NetlinkSocket& socket, uint8_t protocol, uint8_t extensions,
+                     std::vector<char>& requestBuffer, std::vector<char>& receiveBuffer,
+                     const std::function<void(const struct inet_diag_msg&, const void*, size_t)>& fn,
+                     std::string& error) {
+    requestBuffer.clear();
+    NetlinkMessageWriter writer(requestBuffer);
+    uint32_t sequences[FAMILY_COUNT];
+    for (size_t i = 0; i < FAMILY_COUNT; ++i) {
+        struct inet_diag_req_v2 request = {};
+        request.sdiag_family = static_cast<uint8_t>(FAMILIES[i]);
+        request.sdiag_protocol = protocol;
+        request.idiag_states = DUMP_STATES;
+        request.idiag_ext = extensions;
+        sequences[i] = socket.nextSequence();
+        writer.begin(SOCK_DIAG_BY_FAMILY, NLM_F_REQUEST | NLM_F_DUMP, sequences[i]);
+        writer.appendHeader(&request, sizeof(request));
+        writer.end();
+    }
+    if (!socket.send(requestBuffer)) {
+        error = std::string("sock_diag send: ") + strerror(errno);
+        return false;
+    }
+
+    // the kernel answers the requests one after the other, each ending in NLMSG_DONE
+    size_t finished = 0;
+    while (finished < FAMILY_COUNT) {
+        ssize_t length = socket.receive(receiveBuffer, true);
+        if (length < 0) {
+            error = std::string("sock_diag receive: ") + strerror(errno);
+            return false;
+        }
+        for (auto* header = reinterpret_cast<const struct nlmsghdr*>(receiveBuffer.data());
+             NLMSG_OK(header, static_cast<size_t>(length)); header = NLMSG_NEXT(header, length)) {
+            if (std::find(sequences, sequences + FAMILY_COUNT, header->nlmsg_seq) == sequences + FAMILY_COUNT) {
+                continue;
+            }
+            if (header->nlmsg_type == NLMSG_DONE || header->nlmsg_type == NLMSG_ERROR) {
+                // an error here is usually IPv6 being disabled; the other family still counts
+                ++finished;
+            } else if (header->nlmsg_type == SOCK_DIAG_BY_FAMILY &&
+                       header->nlmsg_len >= NLMSG_LENGTH(sizeof(struct inet_diag_msg))) {
+                auto* message = static_cast<const struct inet_diag_msg*>(NLMSG_DATA(header));
+                fn(*message, message + 1, header->nlmsg_len - NLMSG_LENGTH(sizeof(*message)));
+            }
+        }
+    }
+    return true;
+}
+
+SocketOwnerIndex::SocketOwnerIndex() : linksRead(0) {}
+
+void SocketOwnerIndex::update(const std::vector<Socket>& live) {
+    liveInodes.clear();
+    for (const auto& socket : live) {
+        liveInodes.insert(socket.inode);
+    }
+    pruneOwners();
+    if (!findUnplaced(live)) {
+        return;
+    }
+    // both passes only list the fd tables of processes running as an unplaced socket's owner
+    scanOwners(false);
+    // an fd number that was a file last time may have been reused for a socket
+    if (!findUnplaced(live)) {
+        return;
+    }
+    scanOwners(true);
+    for (const auto& socket : live) {
+        if (owners.find(socket.inode) == owners.end()) {
+            unowned.insert(socket.inode);
+        }
+    }
+}
+
+int SocketOwnerIndex::ownerOf(unsigned long long inode) const {
+    auto it = owners.find(inode);
+    return it != owners.end() ? it->second.pid : 0;
+}
+
+const std::string& SocketOwnerIndex::processName(int pid) const {
+    static const std::string unknown = "(unknown)";
+    auto it = ownerProcesses.find(pid);
+    return it != ownerProcesses.end() ? it->second.name : unknown;
+}
+
+unsigned long long SocketOwnerIndex::fdLinksRead() const {
+    return linksRead;
+}
+
+bool SocketOwnerIndex::findUnplaced(const std::vector<Socket>& live) {
+    unplacedUids.clear();
+    for (const auto& socket : live) {
+        if (owners.find(socket.inode) == owners.end() && unowned.find(socket.inode) == unowned.end()) {
+            unplacedUids.insert(socket.uid);
+        }
+    }
+    return !unplacedUids.empty();
+}
+
+void SocketOwnerIndex::pruneOwners() {
+    // forgetting the fd of a closed socket makes the next scan read that fd number again
+    for (auto it = owners.begin(); it != owners.end();) {
+        if (liveInodes.find(it->first) != liveInodes.end()) {
+            ++it;
+            continue;
+        }
+        auto process = ownerProcesses.find(it->second.pid);
+        if (process != ownerProcesses.end()) {
+            auto& fds = process->second.fds;
+            auto fd = std::lower_bound(fds.begin(), fds.end(), it->second.fd);
+            if (fd != fds.end() && *fd == it->second.fd) {
+                fds.erase(fd);
+            }
+        }
+        it = owners.erase(it);
+    }
+    for (auto it = unowned.begin(); it != unowned.end();) {
+        it = liveInodes.find(*it) == liveInodes.end() ? unowned.erase(it) : std::next(it);
+    }
+}
+
+void SocketOwnerIndex::scanOwners(bool full) {
+    DIR* procDir = opendir("/proc");
+    if (procDir == nullptr) {
+        return;
+    }
+    countFileOpen();
+    for (auto& pair : ownerProcesses) {
+        pair.second.seen = false;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(procDir)) != nullptr) {
+        int pid;
+        if (entry->d_type != DT_DIR || !parsePid(entry->d_name, pid)) {
+            continue;
+        }
+        auto inserted = ownerProcesses.try_emplace(pid);
+        OwnerProcess& process = inserted.first->second;
+        if (inserted.second) {
+            int fd = openProcFile("/proc/" + std::to_string(pid) + "/comm");
+            auto content = fd >= 0 ? readProcFile(fd, buffer) : std::nullopt;
+            closeProcFile(fd);
+            if (content) {
+                std::string_view rest = *content;
+                process.name = std::string(nextLine(rest));
+            }
+        }
+        process.seen = true;
+        struct stat status;
+        if (fstatat(dirfd(procDir), entry->d_name, &status, 0) != 0 ||
+            unplacedUids.find(status.st_uid) == unplacedUids.end()) {
+            continue;
+        }
+        scanProcess(pid, process, full);
+    }
+    closedir(procDir);
+
+    for (auto it = ownerProcesses.begin(); it != ownerProcesses.end();) {
+        it = it->second.seen ? std::next(it) : ownerProcesses.erase(it);
+    }
+    // a socket inherited by a child outlives the parent; the next scan finds the child
+    for (auto it = owners.begin(); it != owners.end();) {
+        it = ownerProcesses.count(it->second.pid) ? std::next(it) : owners.erase(it);
+    }
+}
+
+void SocketOwnerIndex::scanProcess(int pid, OwnerProcess& process, bool full) {
+    std::string path = "/proc/" + std::to_string(pid) + "/fd";
+    DIR* fdDir = opendir(path.c_str());
+    if (fdDir == nullptr) {
+        // another user's process, or it just exited
+        process.fds.clear();
+        return;
+    }
+    countFileOpen();
+
+    currentFds.clear();
+    struct dirent* entry;
+    while ((entry = readdir(fdDir)) != nullptr) {
+        int fd;
+        if (!parsePid(entry->d_name, fd)) {
+            continue;
+        }
+        currentFds.push_back(fd);
+        if (!full && std::binary_search(process.fds.begin(), process.fds.end(), fd)) {
+            continue;
+        }
+        char target[64];
+        ssize_t length = readlinkat(dirfd(fdDir), entry->d_name, target, sizeof(target) - 1);
+        ++linksRead;
+        countRead(length > 0 ? static_cast<size_t>(length) : 0);
+        // "socket:[12345]"
+        if (length <= 9 || memcmp(target, "socket:[", 8) != 0) {
+            continue;
+        }
+        std::string_view digits(target + 8, static_cast<size_t>(length) - 9);
+        unsigned long long inode;
+        if (parseUnsigned(digits, inode)) {
+            owners[inode] = {pid, fd};
+        }
+    }
+    closedir(fdDir);
+
+    std::sort(currentFds.begin(), currentFds.end());
+    process.fds.swap(currentFds);
+}
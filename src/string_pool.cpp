@@ -0,0 +1,60 @@
+#include "../include/string_pool.h"
+#include <cstring>
+
+// An id is (block << 16) | offset; each entry is a length byte followed by the characters.
+
+StringPool::StringPool() : blockCount(1), blockUsed(1), full(false) {
+    blocks[0] = std::make_unique<char[]>(BLOCK_SIZE);
+    blocks[0][0] = 0;
+    index.emplace(std::string_view(), EMPTY_ID);
+}
+
+uint32_t StringPool::intern(std::string_view text) {
+    if (text.size() > MAX_LENGTH) {
+        text = text.substr(0, MAX_LENGTH);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(text);
+    if (it != index.end()) {
+        return it->second;
+    }
+
+    size_t entrySize = 1 + text.size();
+    if (blockUsed + entrySize > BLOCK_SIZE) {
+        if (blockCount == MAX_BLOCKS) {
+            full.store(true, std::memory_order_relaxed);
+            return EMPTY_ID;
+        }
+        blocks[blockCount++] = std::make_unique<char[]>(BLOCK_SIZE);
+        blockUsed = 0;
+    }
+
+    char* entry = blocks[blockCount - 1].get() + blockUsed;
+    entry[0] = static_cast<char>(text.size());
+    std::memcpy(entry + 1, text.data(), text.size());
+    uint32_t id = static_cast<uint32_t>(((blockCount - 1) << 16) | blockUsed);
+    blockUsed += entrySize;
+
+    index.emplace(std::string_view(entry + 1, text.size()), id);
+    return id;
+}
+
+std::string_view StringPool::get(uint32_t id) const {
+    const char* entry = blocks[id >> 16].get() + (id & 0xffff);
+    return std::string_view(entry + 1, static_cast<unsigned char>(entry[0]));
+}
+
+bool StringPool::isFull() const {
+    return full.load(std::memory_order_relaxed);
+}
+
+size_t StringPool::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index.size();
+}
+
+size_t StringPool::memoryBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return blockCount * BLOCK_SIZE;
+}
@@ -1,5 +1,6 @@
 #include "../include/system_monitor.h"
 #include "../include/display.h"
+#include "../include/metric_writer.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -8,19 +9,71 @@
 #include <numeric>
 #include <algorithm>
 #include <filesystem>
+#include <mutex>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+#include <csignal>
+#include <ctime>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
 
-bool starts_with(const std::string& str, const std::string& prefix) {
-    return str.size() >= prefix.size() && 
-           std::equal(prefix.begin(), prefix.end(), str.begin());
+const float SystemMonitor::GPU_TEMP_THRESHOLD = 80.0f;
+
+namespace {
+
+int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
 }
 
-const float SystemMonitor::GPU_TEMP_THRESHOLD = 80.0f;
+}
 
-SystemMonitor::SystemMonitor(const Config& config, std::shared_ptr<Logger> logger, Display& display, bool nvml_available)
-    : cpuUsage(0), memoryUsage(0), diskUsage(0), alertTriggered(false), 
-      nvml_available(nvml_available), config(config), logger(logger), display(display),
-      processMonitorThread(config.getUpdateIntervalMs()), gpuUnavailabilityLogged(false),
-      totalMemory(0), totalDiskSpace(0), uptime(0) {}
+SystemMonitor::SystemMonitor(const Config& config, std::shared_ptr<Logger> logger, Display* display, bool nvml_available,
+                             SelfStats& selfStats)
+    : cpuUsage(0), cpuBreakdown(), memoryUsage(0), memoryInfo(), diskUsage(0), cgroupCount(0),
+      history(static_cast<size_t>(std::max(config.getHistoryMemoryMb(), 0)) * 1024 * 1024,
+              config.getHistoryRetentionSeconds()),
+      historyFullLogged(false), namePoolFullLogged(false), alertTriggered(false),
+      nvml_available(nvml_available), config(config),
+      memorySampler(std::make_shared<MemorySampler>()),
+      packetFlowMonitor(config.getPacketCaptureEnabled() ? std::make_shared<PacketFlowMonitor>(config) : nullptr),
+      processMonitorThread(config, memorySampler, selfStats, packetFlowMonitor),
+      gpuUnavailabilityLogged(false),
+      mountMonitor(config.getDiskCapacityIntervalMs(), config.getDiskStatTimeoutMs()),
+      pressureMonitor(config), logger(logger), display(display), outputStat(selfStats.get("output")),
+      totalMemory(0), totalDiskSpace(0), uptime(0), scheduler(config.getCollectorThreads(), selfStats), scheduled(false) {
+    auto add = [this](const char* name, void (SystemMonitor::*collect)()) {
+        scheduler.add(name, this->config.getCollectorIntervalMs(name), [this, collect] { (this->*collect)(); });
+    };
+    add("cpu", &SystemMonitor::collectCpu);
+    add("memory", &SystemMonitor::collectMemory);
+    add("disk", &SystemMonitor::collectDisk);
+    add("gpu", &SystemMonitor::collectGpu);
+    add("network", &SystemMonitor::collectNetwork);
+    add("uptime", &SystemMonitor::collectUptime);
+    add("pressure", &SystemMonitor::collectPressure);
+    // only the display shows these; headless records leave them out like the process table
+    if (display) {
+        add("battery", &SystemMonitor::collectBattery);
+        add("cgroups", &SystemMonitor::collectCgroups);
+        add("connections", &SystemMonitor::collectConnections);
+    }
+    if (packetFlowMonitor) {
+        scheduler.add("packet_flow", config.getCollectorIntervalMs("packet_flow"), [this] { packetFlowMonitor->update(); });
+    }
+
+    // created first, so a spent budget only ever costs per-device series
+    cpuSeries = historySeries("cpu", "cpu");
+    memorySeries = historySeries("memory", "memory");
+    diskSeries = historySeries("disk", "disk");
+    for (PressureResource resource : {PressureResource::Cpu, PressureResource::Memory, PressureResource::Io}) {
+        pressureSeries[static_cast<size_t>(resource)] =
+            historySeries(std::string("psi.") + PressureMonitor::resourceName(resource) + ".some", "pressure");
+    }
+}
 
 bool SystemMonitor::initialize() {
     if (!initializeGPU()) {
@@ -29,7 +82,39 @@ bool SystemMonitor::initialize() {
     initializeCpuInfo();
     initializeMemoryInfo();
     initializeDiskInfo();
-    processMonitorThread.start();
+    if (!pressureMonitor.isAvailable()) {
+        logger->logInfo("Pressure stall information not available in this kernel");
+    } else if (!pressureMonitor.getTriggerError().empty()) {
+        logger->logWarning("PSI triggers unavailable, stalls are only seen each tick: " + pressureMonitor.getTriggerError());
+        if (display) display->addLogMessage("PSI triggers unavailable: " + pressureMonitor.getTriggerError());
+    }
+    if (!networkMonitor.getError().empty()) {
+        logger->logWarning("Network monitoring degraded: " + networkMonitor.getError());
+    }
+    if (!connectionMonitor.getError().empty()) {
+        logger->logWarning("TCP connection view unavailable: " + connectionMonitor.getError());
+    }
+    if (!cgroupMonitor.isAvailable()) {
+        logger->logInfo("No cgroup v2 hierarchy mounted, cgroup view disabled");
+    }
+    if (packetFlowMonitor) {
+        std::string error;
+        if (!packetFlowMonitor->start(error)) {
+            logger->logWarning("Per-process network rates unavailable: " + error);
+        }
+    }
+    // nothing shows the process table headless, so don't pay for the scans
+    if (display) {
+        processMonitorThread.start();
+    }
+
+    // one synchronous pass so the first frame has data, then every collector on its own timer
+    update();
+    std::string error;
+    scheduled = scheduler.start(error);
+    if (!scheduled) {
+        logger->logWarning("Collector scheduler unavailable, sampling everything each tick: " + error);
+    }
     return true;
 }
 
@@ -49,34 +134,18 @@ void SystemMonitor::initializeCpuInfo() {
 }
 
 void SystemMonitor::initializeMemoryInfo() {
-    std::ifstream meminfo("/proc/meminfo");
-    std::string line;
-    while (std::getline(meminfo, line)) {
-        if (line.find("MemTotal:") != std::string::npos) {
-            std::istringstream iss(line);
-            std::string key;
-            unsigned long long value;
-            iss >> key >> value;
-            totalMemory = value * 1024; // Convert from KB to bytes
-            break;
-        }
-    }
+    totalMemory = memorySampler->info().memTotal * 1024; // Convert from KB to bytes
 }
 
 void SystemMonitor::initializeDiskInfo() {
-    try {
-        std::string rootDevice = getRootDeviceName();
-        if (!rootDevice.empty()) {
-            diskName = rootDevice;
-            auto space = std::filesystem::space("/");
-            totalDiskSpace = space.capacity;
-        } else {
-            logger->logError("No suitable drive found");
-        }
-    } catch (const std::filesystem::filesystem_error& e) {
-        logger->logError("Error getting disk info: " + std::string(e.what()));
+    std::string rootDevice = getRootDeviceName();
+    if (!rootDevice.empty()) {
+        diskName = rootDevice;
+    } else {
+        logger->logError("No suitable drive found");
     }
-    updateDiskPartitions();
+    // capacities arrive from the mount monitor's own thread, so a hung mount cannot stall startup either
+    mountMonitor.start();
 }
 
 std::string SystemMonitor::getRootDeviceName() {
@@ -98,56 +167,57 @@ bool SystemMonitor::initializeGPU() {
         try {
             if (!gpuMonitor.initialize()) {
                 logger->logError("Failed to initialize GPU monitor");
-                display.addLogMessage("GPU monitoring unavailable: Failed to initialize");
+                if (display) display->addLogMessage("GPU monitoring unavailable: Failed to initialize");
                 gpuUnavailabilityLogged = true;
                 return false;
             }
         } catch (const std::exception& e) {
             logger->logError("Exception during GPU monitor initialization: " + std::string(e.what()));
-            display.addLogMessage("GPU monitoring unavailable: " + std::string(e.what()));
+            if (display) display->addLogMessage("GPU monitoring unavailable: " + std::string(e.what()));
             gpuUnavailabilityLogged = true;
             return false;
         } catch (...) {
             logger->logError("Unknown exception during GPU monitor initialization");
-            display.addLogMessage("GPU monitoring unavailable: Unknown error");
+            if (display) display->addLogMessage("GPU monitoring unavailable: Unknown error");
             gpuUnavailabilityLogged = true;
             return false;
         }
     } else if (!gpuUnavailabilityLogged) {
         logger->logWarning("GPU monitoring is not available");
-        display.addLogMessage("GPU monitoring not available");
+        if (display) display->addLogMessage("GPU monitoring not available");
         gpuUnavailabilityLogged = true;
     }
     return nvml_available;
 }
 
 void SystemMonitor::update() {
-    cpuUsage = calculateCpuUsage();
-    updateCPUCoreInfo();
-    memoryUsage = calculateMemoryUsage();
-    diskUsage = calculateDiskUsage();
-    updateDiskPartitions();
-    if (nvml_available) {
-        gpuMonitor.update();
-    }
-    networkMonitor.update();
-    batteryMonitor.update();
-    updateUptime();
-    checkAlerts();
+    scheduler.runAll();
 }
 
 double SystemMonitor::getCpuUsage() const {
     return cpuUsage;
 }
 
+const CpuBreakdown& SystemMonitor::getCpuBreakdown() const {
+    return cpuBreakdown;
+}
+
 const std::vector<CPUCoreInfo>& SystemMonitor::getCPUCoreInfo() const {
     return cpuCoreInfo;
 }
 
+const std::vector<TemperatureSensor>& SystemMonitor::getTemperatureSensors() const {
+    return temperatureSensors;
+}
+
 double SystemMonitor::getMemoryUsage() const {
     return memoryUsage;
 }
 
+const MemoryInfo& SystemMonitor::getMemoryInfo() const {
+    return memoryInfo;
+}
+
 double SystemMonitor::getDiskUsage() const {
     return diskUsage;
 }
@@ -156,15 +226,50 @@ const std::vector<DiskPartitionInfo>& SystemMonitor::getDiskPartitions() const {
     return diskPartitions;
 }
 
-std::vector<ProcessInfo> SystemMonitor::getProcesses() const {
-    return processMonitorThread.getProcesses();
+const std::vector<DiskIOStats>& SystemMonitor::getDiskIOStats() const {
+    return diskIOStats;
 }
 
-std::vector<GPUInfo> SystemMonitor::getGPUInfo() const {
-    if (nvml_available) {
-        return gpuMonitor.getGPUInfo();
+const ResourcePressure& SystemMonitor::getPressure(PressureResource resource) const {
+    return pressureMonitor.get(resource);
+}
+
+const std::vector<CgroupInfo>& SystemMonitor::getCgroups(size_t visibleRows) const {
+    cgroupMonitor.setDetailRows(visibleRows);
+    return cgroupRows;
+}
+
+size_t SystemMonitor::getCgroupCount() const {
+    return cgroupCount;
+}
+
+const std::vector<TcpConnection>& SystemMonitor::getConnections() const {
+    return connections;
+}
+
+const std::vector<ProcessConnections>& SystemMonitor::getConnectionsByProcess() const {
+    return connectionsByProcess;
+}
+
+std::shared_ptr<const ProcessSnapshot> SystemMonitor::getProcesses(size_t visibleRows) const {
+    auto processes = processMonitorThread.getProcesses(visibleRows);
+    if (!namePoolFullLogged && processes->names && processes->names->isFull()) {
+        logger->logWarning("Process name pool is full, processes seen from now on are listed without a name");
+        namePoolFullLogged = true;
     }
-    return {};
+    return processes;
+}
+
+ProcessDeltaTable::Stats SystemMonitor::getProcessDeltaStats() const {
+    return processMonitorThread.getDeltaTableStats();
+}
+
+void SystemMonitor::setExpandedPids(const std::vector<int>& pids) const {
+    processMonitorThread.setExpandedPids(pids);
+}
+
+const std::vector<GPUInfo>& SystemMonitor::getGPUInfo() const {
+    return gpuInfo;
 }
 
 bool SystemMonitor::isAlertTriggered() const {
@@ -192,154 +297,214 @@ std::string SystemMonitor::getDiskName() const {
 }
 
 const BatteryMonitor& SystemMonitor::getBatteryMonitor() const {
-    return batteryMonitor;
+    return battery;
 }
 
 long SystemMonitor::getUptime() const {
     return uptime;
 }
 
-double SystemMonitor::calculateCpuUsage() {
-    static unsigned long long lastTotalUser = 0, lastTotalUserLow = 0, lastTotalSys = 0, lastTotalIdle = 0;
-
-    std::ifstream statFile("/proc/stat");
-    std::string line;
-    std::getline(statFile, line);
-    std::istringstream ss(line);
-
-    std::string cpu;
-    unsigned long long totalUser, totalUserLow, totalSys, totalIdle, totalIOwait, totalIRQ, totalSoftIRQ;
-
-    ss >> cpu >> totalUser >> totalUserLow >> totalSys >> totalIdle >> totalIOwait >> totalIRQ >> totalSoftIRQ;
+const MetricHistory& SystemMonitor::getHistory() const {
+    return history;
+}
 
-    if (lastTotalUser == 0) {
-        lastTotalUser = totalUser;
-        lastTotalUserLow = totalUserLow;
-        lastTotalSys = totalSys;
-        lastTotalIdle = totalIdle;
-        return 0.0;
+void SystemMonitor::collectCpu() {
+    if (!cpuSampler.sample()) {
+        return;
+    }
+    const auto& cores = cpuSampler.cores();
+    // CPUs can be hotplugged, so the list follows what /proc/stat reports rather than the startup count
+    sampledCores.resize(cores.size(), CPUCoreInfo{});
+    sensorRegistry.update(cores);
+
+    for (size_t coreIndex = 0; coreIndex < cores.size(); ++coreIndex) {
+        auto& core = sampledCores[coreIndex];
+        core.breakdown = cores[coreIndex];
+        core.utilization = cores[coreIndex].utilization;
+        core.temperature = sensorRegistry.coreTemperature(coreIndex).value_or(0.0);
+        core.clockSpeed = sensorRegistry.coreFrequency(coreIndex).value_or(0.0);
     }
 
-    unsigned long long total = (totalUser - lastTotalUser) + (totalUserLow - lastTotalUserLow) +
-                               (totalSys - lastTotalSys);
-    total += (totalIdle - lastTotalIdle);
-    double percent = (total - (totalIdle - lastTotalIdle)) / static_cast<double>(total);
-
-    lastTotalUser = totalUser;
-    lastTotalUserLow = totalUserLow;
-    lastTotalSys = totalSys;
-    lastTotalIdle = totalIdle;
+    int64_t now = nowMs();
+    std::unique_lock<std::shared_mutex> lock(stateMutex);
+    cpuUsage = cpuSampler.aggregate().utilization;
+    cpuBreakdown = cpuSampler.aggregate();
+    cpuCoreInfo = sampledCores;
+    temperatureSensors = sensorRegistry.sensors();
 
-    return percent * 100.0;
+    history.append(cpuSeries, now, static_cast<float>(cpuUsage));
+    while (coreSeries.size() < sampledCores.size()) {
+        coreSeries.push_back(historySeries("cpu.core" + std::to_string(coreSeries.size()), "cpu"));
+    }
+    for (size_t i = 0; i < sampledCores.size(); ++i) {
+        history.append(coreSeries[i], now, static_cast<float>(sampledCores[i].utilization));
+    }
 }
 
-void SystemMonitor::updateCPUCoreInfo() {
-    std::ifstream statFile("/proc/stat");
-    std::string line;
-    int coreIndex = 0;
-
-    while (std::getline(statFile, line) && coreIndex < cpuCoreInfo.size()) {
-        if (line.substr(0, 3) == "cpu" && line[3] != ' ') {
-            std::istringstream ss(line);
-            std::string cpu;
-            unsigned long long user, nice, system, idle, iowait, irq, softirq, steal, guest, guest_nice;
-            
-            ss >> cpu >> user >> nice >> system >> idle >> iowait >> irq >> softirq >> steal >> guest >> guest_nice;
-
-            unsigned long long totalTime = user + nice + system + idle + iowait + irq + softirq + steal;
-            unsigned long long idleTime = idle + iowait;
-
-            static std::vector<unsigned long long> lastTotalTime(cpuCoreInfo.size(), 0);
-            static std::vector<unsigned long long> lastIdleTime(cpuCoreInfo.size(), 0);
-
-            if (lastTotalTime[coreIndex] != 0) {
-                unsigned long long totalTimeDiff = totalTime - lastTotalTime[coreIndex];
-                unsigned long long idleTimeDiff = idleTime - lastIdleTime[coreIndex];
-                cpuCoreInfo[coreIndex].utilization = 100.0 * (1.0 - static_cast<double>(idleTimeDiff) / totalTimeDiff);
-            }
+void SystemMonitor::collectMemory() {
+    if (!memorySampler->sample()) {
+        return;
+    }
+    int64_t now = nowMs();
+    std::unique_lock<std::shared_mutex> lock(stateMutex);
+    memoryInfo = memorySampler->info();
+    totalMemory = memoryInfo.memTotal * 1024;
+    memoryUsage = memoryInfo.usedPercent();
+    history.append(memorySeries, now, static_cast<float>(memoryUsage));
+}
 
-            lastTotalTime[coreIndex] = totalTime;
-            lastIdleTime[coreIndex] = idleTime;
+void SystemMonitor::collectDisk() {
+    mountMonitor.update();
+    bool partitionsChanged = mountMonitor.refreshPartitions(sampledPartitions);
+    auto root = mountMonitor.root();
+    diskIOMonitor.update();
 
-            // Read core temperature (this might need to be adjusted based on your system)
-            std::ifstream tempFile("/sys/class/thermal/thermal_zone" + std::to_string(coreIndex) + "/temp");
-            int temp;
-            if (tempFile >> temp) {
-                cpuCoreInfo[coreIndex].temperature = temp / 1000.0; // Convert from millidegrees to degrees
-            }
-
-            // Read core clock speed
-            std::ifstream freqFile("/sys/devices/system/cpu/cpu" + std::to_string(coreIndex) + "/cpufreq/scaling_cur_freq");
-            unsigned long long freq;
-            if (freqFile >> freq) {
-                cpuCoreInfo[coreIndex].clockSpeed = freq / 1000000.0; // Convert from kHz to GHz
-            }
+    int64_t now = nowMs();
+    std::unique_lock<std::shared_mutex> lock(stateMutex);
+    if (partitionsChanged) {
+        diskPartitions = sampledPartitions;
+    }
+    if (root && root->totalSpace != 0) {
+        totalDiskSpace = root->totalSpace;
+        diskUsage = 100.0 * static_cast<double>(root->usedSpace) / root->totalSpace;
+    }
+    diskIOStats = diskIOMonitor.getDevices();
 
-            coreIndex++;
+    history.append(diskSeries, now, static_cast<float>(diskUsage));
+    for (auto& entry : deviceSeries) {
+        entry.second.seen = false;
+    }
+    for (const auto& device : diskIOStats) {
+        if (!device.parent.empty()) {
+            continue;
+        }
+        auto inserted = deviceSeries.try_emplace(device.name);
+        DeviceSeries& series = inserted.first->second;
+        if (inserted.second) {
+            series.utilization = historySeries("diskio." + device.label + ".util", "disk");
+        }
+        series.seen = true;
+        history.append(series.utilization, now, static_cast<float>(device.utilization));
+    }
+    // DiskIOMonitor drops devices that are gone, so an unseen device has been removed
+    for (auto it = deviceSeries.begin(); it != deviceSeries.end();) {
+        if (it->second.seen) {
+            ++it;
+        } else {
+            history.retire(it->second.utilization);
+            it = deviceSeries.erase(it);
         }
     }
 }
 
-double SystemMonitor::calculateMemoryUsage() {
-    std::ifstream meminfo("/proc/meminfo");
-    std::string line;
-    long long totalMem = 0, freeMem = 0, buffers = 0, cached = 0;
+void SystemMonitor::collectGpu() {
+    if (!nvml_available) {
+        return;
+    }
+    gpuMonitor.update();
+    auto gpus = gpuMonitor.getGPUInfo();
+    int64_t now = nowMs();
+    std::unique_lock<std::shared_mutex> lock(stateMutex);
+    gpuInfo.swap(gpus);
+    while (gpuSeries.size() < gpuInfo.size()) {
+        std::string prefix = "gpu." + std::to_string(gpuInfo[gpuSeries.size()].index);
+        gpuSeries.emplace_back(historySeries(prefix + ".util", "gpu"), historySeries(prefix + ".temp", "gpu"));
+    }
+    for (size_t i = 0; i < gpuInfo.size(); ++i) {
+        history.append(gpuSeries[i].first, now, gpuInfo[i].gpuUtilization);
+        history.append(gpuSeries[i].second, now, gpuInfo[i].temperature);
+    }
+}
 
-    while (std::getline(meminfo, line)) {
-        std::istringstream iss(line);
-        std::string key;
-        long long value;
-
-        if (iss >> key >> value) {
-            if (key == "MemTotal:") totalMem = value;
-            else if (key == "MemFree:") freeMem = value;
-            else if (key == "Buffers:") buffers = value;
-            else if (key == "Cached:") cached = value;
+void SystemMonitor::collectNetwork() {
+    networkMonitor.update();
+    auto interfaces = networkMonitor.getActiveInterfaces();
+    int64_t now = nowMs();
+    std::unique_lock<std::shared_mutex> lock(stateMutex);
+    networkInterfaces.swap(interfaces);
+    for (auto& entry : linkSeries) {
+        entry.second.seen = false;
+    }
+    for (const auto& interface : networkInterfaces) {
+        auto it = linkSeries.find(interface.index);
+        if (it != linkSeries.end() && it->second.name == interface.name) {
+            it->second.seen = true;
         }
     }
+    // a link that is only down keeps its history; one that is gone or renamed frees it first,
+    // so a replacement taking the same name gets a fresh series
+    for (auto it = linkSeries.begin(); it != linkSeries.end();) {
+        if (!it->second.seen && !networkMonitor.hasLink(it->first, it->second.name)) {
+            history.retire(it->second.receive);
+            history.retire(it->second.send);
+            it = linkSeries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (const auto& interface : networkInterfaces) {
+        auto inserted = linkSeries.try_emplace(interface.index);
+        LinkSeries& series = inserted.first->second;
+        if (inserted.second) {
+            series.name = interface.name;
+            series.receive = historySeries("net." + interface.name + ".rx", "network");
+            series.send = historySeries("net." + interface.name + ".tx", "network");
+        }
+        history.append(series.receive, now, static_cast<float>(interface.downloadSpeed));
+        history.append(series.send, now, static_cast<float>(interface.uploadSpeed));
+    }
+}
 
-    auto usedMem = totalMem - freeMem - buffers - cached;
-    return 100.0 * static_cast<double>(usedMem) / totalMem;
+void SystemMonitor::collectBattery() {
+    batteryMonitor.update();
+    std::unique_lock<std::shared_mutex> lock(stateMutex);
+    battery = batteryMonitor;
 }
 
-double SystemMonitor::calculateDiskUsage() {
-    try {
-        auto space = std::filesystem::space("/");
-        auto totalSpace = space.capacity;
-        auto freeSpace = space.free;
-        auto usedSpace = totalSpace - freeSpace;
+void SystemMonitor::collectUptime() {
+    struct sysinfo si;
+    if (sysinfo(&si) == 0) {
+        std::unique_lock<std::shared_mutex> lock(stateMutex);
+        uptime = si.uptime;
+    }
+}
 
-        return 100.0 * static_cast<double>(usedSpace) / totalSpace;
-    } catch (const std::filesystem::filesystem_error& e) {
-        logger->logError("Error calculating disk usage: " + std::string(e.what()));
-        return 0.0;
+void SystemMonitor::collectPressure() {
+    // read in place by the getters and by reportStalls, so it samples under the lock; it is three small files
+    int64_t now = nowMs();
+    std::unique_lock<std::shared_mutex> lock(stateMutex);
+    pressureMonitor.update();
+    for (PressureResource resource : {PressureResource::Cpu, PressureResource::Memory, PressureResource::Io}) {
+        const auto& pressure = pressureMonitor.get(resource);
+        if (pressure.available) {
+            history.append(pressureSeries[static_cast<size_t>(resource)], now, static_cast<float>(pressure.some.avg10));
+        }
     }
 }
 
-void SystemMonitor::updateDiskPartitions() {
-    diskPartitions.clear();
-    std::ifstream mountsFile("/proc/mounts");
-    std::string line;
+MetricHistory::SeriesId SystemMonitor::historySeries(const std::string& name, const char* collector) {
+    auto id = history.series(name, config.getCollectorIntervalMs(collector));
+    if (id == MetricHistory::NO_SERIES && !historyFullLogged) {
+        logger->logWarning("history_memory_mb is spent, " + name + " and later series keep no history");
+        historyFullLogged = true;
+    }
+    return id;
+}
 
-    while (std::getline(mountsFile, line)) {
-        std::istringstream iss(line);
-        std::string device, mountPoint, fsType;
-        iss >> device >> mountPoint >> fsType;
-
-        if (starts_with(device, "/dev/") && fsType != "tmpfs" && fsType != "devtmpfs") {
-            try {
-                auto space = std::filesystem::space(mountPoint);
-                DiskPartitionInfo partInfo;
-                partInfo.name = device.substr(5); // Remove "/dev/" prefix
-                partInfo.mountPoint = mountPoint;
-                partInfo.totalSpace = space.capacity;
-                partInfo.usedSpace = space.capacity - space.free;
-                diskPartitions.push_back(partInfo);
-            } catch (const std::filesystem::filesystem_error& e) {
-                logger->logError("Error getting partition info for " + device + ": " + e.what());
-            }
-        }
+void SystemMonitor::collectCgroups() {
+    cgroupMonitor.update();
+    std::unique_lock<std::shared_mutex> lock(stateMutex);
+    cgroupRows = cgroupMonitor.getCgroups();
+    cgroupCount = cgroupMonitor.cgroupCount();
+}
+
+void SystemMonitor::collectConnections() {
+    if (!connectionMonitor.update()) {
+        return;
     }
+    std::unique_lock<std::shared_mutex> lock(stateMutex);
+    connections = connectionMonitor.getConnections();
+    connectionsByProcess = connectionMonitor.getProcesses();
 }
 
 void SystemMonitor::checkAlerts() {
@@ -347,60 +512,207 @@ void SystemMonitor::checkAlerts() {
     bool memoryAlert = memoryUsage > config.getMemoryThreshold();
     bool diskAlert = diskUsage > config.getDiskThreshold();
 
-    if (cpuAlert || memoryAlert || diskAlert) {
+    std::string diskIOAlert;
+    for (const auto& device : diskIOStats) {
+        // partitions are covered by their whole disk
+        if (!device.parent.empty()) {
+            continue;
+        }
+        double latency = std::max(device.readLatencyMs, device.writeLatencyMs);
+        if (device.utilization > config.getDiskIOUtilThreshold()) {
+            diskIOAlert += " DiskIO=" + device.label + " " + std::to_string(device.utilization) + "%";
+        } else if (latency > config.getDiskIOLatencyThresholdMs()) {
+            diskIOAlert += " DiskIO=" + device.label + " " + std::to_string(latency) + "ms";
+        }
+    }
+
+    if (cpuAlert || memoryAlert || diskAlert || !diskIOAlert.empty()) {
         std::string alertMessage = "Alert triggered:";
         if (cpuAlert) alertMessage += " CPU=" + std::to_string(cpuUsage) + "%";
         if (memoryAlert) alertMessage += " Memory=" + std::to_string(memoryUsage) + "%";
         if (diskAlert) alertMessage += " Disk=" + std::to_string(diskUsage) + "%";
+        alertMessage += diskIOAlert;
         
         logger->logWarning(alertMessage);
-        display.showAlert(alertMessage);
+        if (display) display->showAlert(alertMessage);
         alertTriggered = true;
     } else {
         alertTriggered = false;
     }
 
     if (nvml_available) {
-        auto gpuInfos = gpuMonitor.getGPUInfo();
-        for (const auto& gpu : gpuInfos) {
+        for (const auto& gpu : gpuInfo) {
             if (gpu.temperature > GPU_TEMP_THRESHOLD) {
                 std::string gpuAlertMessage = "GPU " + std::to_string(gpu.index) + 
                                               " temperature alert: " + 
                                               std::to_string(gpu.temperature) + "°C (Threshold: " +
                                               std::to_string(GPU_TEMP_THRESHOLD) + "°C)";
                 logger->logWarning(gpuAlertMessage);
-                display.showAlert(gpuAlertMessage);
+                if (display) display->showAlert(gpuAlertMessage);
                 alertTriggered = true;
             }
         }
     }
 }
 
-std::vector<NetworkInterface> SystemMonitor::getNetworkInterfaces() const {
-    return networkMonitor.getActiveInterfaces();
+void SystemMonitor::reportStalls(const std::vector<PressureResource>& stalls) {
+    // the trigger fired mid-interval, so refresh the averages it is reported with
+    std::unique_lock<std::shared_mutex> lock(stateMutex);
+    pressureMonitor.update();
+    for (PressureResource resource : stalls) {
+        const auto& pressure = pressureMonitor.get(resource);
+        std::string message = std::string("Pressure stall: ") + PressureMonitor::resourceName(resource) +
+                              " (" + pressureMonitor.getTrigger(resource) + ") avg10 some=" +
+                              std::to_string(pressure.some.avg10) + "%";
+        if (pressure.hasFull) {
+            message += " full=" + std::to_string(pressure.full.avg10) + "%";
+        }
+        logger->logWarning(message);
+        if (display) display->showAlert(message);
+    }
+    alertTriggered = true;
 }
 
-void SystemMonitor::updateUptime() {
-    struct sysinfo si;
-    if (sysinfo(&si) == 0) {
-        uptime = si.uptime;
-    }
+const std::vector<NetworkInterface>& SystemMonitor::getNetworkInterfaces() const {
+    return networkInterfaces;
 }
 
-void SystemMonitor::run() {
-    while (true) {
-        update();
-        display.update(*this);
-        
-        auto start = std::chrono::steady_clock::now();
-        while (std::chrono::duration_cast<std::chrono::milliseconds>(
-                   std::chrono::steady_clock::now() - start).count() < config.getUpdateIntervalMs()) {
-            if (!display.handleInput()) {
-                processMonitorThread.stop();
-                return;
+void SystemMonitor::run(MetricWriter* records) {
+    // Sleeps in epoll until something needs doing: a key, a collector publishing, a PSI trigger
+    // or the display tick that keeps the clock and alerts current. Headless, the tick writes a
+    // record instead and a signal stands in for 'q'.
+    enum : uint64_t { INPUT = 0, SIGNAL, TICK, DATA_READY, STALL };
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    int tickFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    int signalFd = -1;
+    if (!display) {
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        signalFd = signalfd(-1, &signals, SFD_CLOEXEC | SFD_NONBLOCK);
+    }
+    if (epollFd < 0 || tickFd < 0 || (!display && signalFd < 0)) {
+        throw std::runtime_error(std::string("event loop setup: ") + strerror(errno));
+    }
+    int intervalMs = std::max(display ? config.getUpdateIntervalMs() : config.getRecordIntervalMs(), 1);
+    struct itimerspec tick = {};
+    tick.it_interval.tv_sec = intervalMs / 1000;
+    tick.it_interval.tv_nsec = static_cast<long>(intervalMs % 1000) * 1000000;
+    tick.it_value = tick.it_interval;
+    timerfd_settime(tickFd, 0, &tick, nullptr);
+    // alerts are checked, and logged, once per update interval however often records are written
+    uint64_t alertTicks = static_cast<uint64_t>(std::max(std::max(config.getUpdateIntervalMs(), 1) / intervalMs, 1));
+    uint64_t ticksSinceAlert = alertTicks;
+
+    auto watch = [epollFd](int fd, uint32_t events, uint64_t tag) {
+        struct epoll_event event = {};
+        event.events = events;
+        event.data.u64 = tag;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    };
+    if (display) {
+        watch(STDIN_FILENO, EPOLLIN, INPUT);
+        if (scheduled) {
+            watch(scheduler.readyFd(), EPOLLIN, DATA_READY);
+        }
+    } else {
+        watch(signalFd, EPOLLIN, SIGNAL);
+    }
+    watch(tickFd, EPOLLIN, TICK);
+    const PressureResource resources[] = {PressureResource::Cpu, PressureResource::Memory, PressureResource::Io};
+    for (PressureResource resource : resources) {
+        int fd = pressureMonitor.getTriggerFd(resource);
+        if (fd >= 0) {
+            watch(fd, EPOLLPRI, STALL + static_cast<uint64_t>(resource));
+        }
+    }
+
+    std::vector<PressureResource> stalls;
+    bool redraw = display != nullptr;
+    bool quit = false;
+    struct epoll_event events[8];
+    while (!quit) {
+        if (redraw) {
+            // collectors publish between frames, never during one
+            std::shared_lock<std::shared_mutex> lock(stateMutex);
+            display->update(*this);
+            redraw = false;
+        }
+
+        int count = epoll_wait(epollFd, events, 8, -1);
+        if (count < 0 && errno != EINTR) {
+            break;
+        }
+        stalls.clear();
+        for (int i = 0; i < count; ++i) {
+            uint64_t tag = events[i].data.u64;
+            uint64_t value;
+            if (tag == INPUT) {
+                // a hung-up terminal stays readable forever with nothing to read
+                if ((events[i].events & (EPOLLHUP | EPOLLERR)) || !display->handleInput()) {
+                    quit = true;
+                    break;
+                }
+                std::shared_lock<std::shared_mutex> lock(stateMutex);
+                display->forceUpdate(*this);
+            } else if (tag == SIGNAL) {
+                quit = true;
+                break;
+            } else if (tag == TICK) {
+                if (read(tickFd, &value, sizeof(value)) == sizeof(value)) {
+                    if (!scheduled) {
+                        update();
+                    }
+                    redraw = display != nullptr;
+                    ticksSinceAlert += value;
+                    if (ticksSinceAlert >= alertTicks) {
+                        ticksSinceAlert = 0;
+                        std::shared_lock<std::shared_mutex> lock(stateMutex);
+                        checkAlerts();
+                    }
+                    if (records) {
+                        struct timespec now;
+                        clock_gettime(CLOCK_REALTIME, &now);
+                        SelfStatScope scope(outputStat);
+                        std::shared_lock<std::shared_mutex> lock(stateMutex);
+                        if (!records->write(*this, static_cast<unsigned long long>(now.tv_sec) * 1000000000ULL +
+                                                       static_cast<unsigned long long>(now.tv_nsec))) {
+                            logger->logError("Stopping: " + records->getError());
+                            quit = true;
+                            break;
+                        }
+                    }
+                }
+            } else if (tag == DATA_READY) {
+                if (read(scheduler.readyFd(), &value, sizeof(value)) == sizeof(value)) {
+                    redraw = true;
+                }
+            } else {
+                // epoll's answer is the event: polling the trigger again would find it consumed
+                auto resource = static_cast<PressureResource>(tag - STALL);
+                if (events[i].events & EPOLLERR) {
+                    epoll_ctl(epollFd, EPOLL_CTL_DEL, pressureMonitor.getTriggerFd(resource), nullptr);
+                    pressureMonitor.dropTrigger(resource);
+                } else {
+                    stalls.push_back(resource);
+                }
             }
-            display.forceUpdate(*this);
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        if (!stalls.empty()) {
+            reportStalls(stalls);
         }
     }
-}
\ No newline at end of file
+
+    if (signalFd >= 0) {
+        close(signalFd);
+    }
+    close(tickFd);
+    close(epollFd);
+    scheduler.stop();
+    processMonitorThread.stop();
+    mountMonitor.stop();
+    if (packetFlowMonitor) {
+        packetFlowMonitor->stop();
+    }
+}
@@ -0,0 +1,294 @@
+#include "../include/taskstats_client.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <linux/genetlink.h>
+#include <linux/taskstats.h>
+
+namespace {
+constexpr size_t BATCH_SIZE = 32;
+constexpr size_t REPLY_SIZE = 1024;
+constexpr int SOCKET_BUFFER_SIZE = 4 * 1024 * 1024;
+
+void growReceiveBuffer(int fd) {
+    int size = SOCKET_BUFFER_SIZE;
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) != 0) {
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+}
+}
+
+TaskstatsClient::TaskstatsClient() : familyId(0) {}
+
+bool TaskstatsClient::open(std::string& error) {
+    if (!querySocket.open(NETLINK_GENERIC, 0, error) || !resolveFamily(error)) {
+        querySocket.close();
+        return false;
+    }
+    growReceiveBuffer(querySocket.fd());
+
+    // a probe on ourselves tells us whether we are allowed to query at all
+    std::vector<int> self = {static_cast<int>(getpid())};
+    std::vector<TaskstatsSample> samples;
+    std::vector<char> valid;
+    errno = 0;
+    query(self, samples, valid);
+    if (!valid[0]) {
+        error = std::string("taskstats: ") + strerror(errno ? errno : EPERM);
+        querySocket.close();
+        return false;
+    }
+    return true;
+}
+
+bool TaskstatsClient::isOpen() const {
+    return querySocket.isOpen();
+}
+
+bool TaskstatsClient::resolveFamily(std::string& error) {
+    requestBuffer.clear();
+    NetlinkMessageWriter writer(requestBuffer);
+    writer.begin(GENL_ID_CTRL, NLM_F_REQUEST, querySocket.nextSequence());
+    struct genlmsghdr genl = {};
+    genl.cmd = CTRL_CMD_GETFAMILY;
+    genl.version = 1;
+    writer.appendHeader(&genl, sizeof(genl));
+    writer.addAttribute(CTRL_ATTR_FAMILY_NAME, TASKSTATS_GENL_NAME, sizeof(TASKSTATS_GENL_NAME));
+    writer.end();
+
+    if (!querySocket.send(requestBuffer)) {
+        error = std::string("taskstats: ") + strerror(errno);
+        return false;
+    }
+
+    ssize_t length = querySocket.receive(receiveBuffer, true);
+    auto* header = reinterpret_cast<const struct nlmsghdr*>(receiveBuffer.data());
+    if (length <= 0 || !NLMSG_OK(header, static_cast<size_t>(length)) || header->nlmsg_type == NLMSG_ERROR) {
+        error = "taskstats: generic netlink family not available";
+        return false;
+    }
+
+    const char* payload = static_cast<const char*>(NLMSG_DATA(header)) + GENL_HDRLEN;
+    size_t payloadLength = header->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+    forEachNetlinkAttribute(payload, payloadLength, [this](uint16_t type, const char* data, size_t size) {
+        if (type == CTRL_ATTR_FAMILY_ID && size >= sizeof(uint16_t)) {
+            memcpy(&familyId, data, sizeof(familyId));
+        }
+    });
+    if (familyId == 0) {
+        error = "taskstats: family id missing from reply";
+        return false;
+    }
+    return true;
+}
+
+void TaskstatsClient::queueRequest(NetlinkMessageWriter& writer, uint16_t attribute, int id, uint32_t sequence, uint16_t flags) {
+    writer.begin(familyId, NLM_F_REQUEST | flags, sequence);
+    struct genlmsghdr genl = {};
+    genl.cmd = TASKSTATS_CMD_GET;
+    genl.version = TASKSTATS_GENL_VERSION;
+    writer.appendHeader(&genl, sizeof(genl));
+    uint32_t value = static_cast<uint32_t>(id);
+    writer.addAttribute(attribute, &value, sizeof(value));
+    writer.end();
+}
+
+void TaskstatsClient::query(const std::vector<int>& tgids, std::vector<TaskstatsSample>& samples, std::vector<char>& valid) {
+    samples.resize(tgids.size());
+    valid.assign(tgids.size(), 0);
+    if (!querySocket.isOpen()) {
+        return;
+    }
+
+    replyBuffers.resize(BATCH_SIZE * 2 * REPLY_SIZE);
+    replyVectors.resize(BATCH_SIZE * 2);
+    replyMessages.resize(BATCH_SIZE * 2);
+
+    for (size_t start = 0; start < tgids.size(); start += BATCH_SIZE) {
+        size_t count = std::min(BATCH_SIZE, tgids.size() - start);
+        uint32_t baseSequence = querySocket.nextSequence();
+        // reserve one sequence number per request so replies can be matched back to their slot
+        for (size_t i = 1; i < count * 2; ++i) querySocket.nextSequence();
+
+        requestBuffer.clear();
+        NetlinkMessageWriter writer(requestBuffer);
+        for (size_t i = 0; i < count; ++i) {
+            int tgid = tgids[start + i];
+            queueRequest(writer, TASKSTATS_CMD_ATTR_PID, tgid, baseSequence + static_cast<uint32_t>(2 * i), 0);
+            queueRequest(writer, TASKSTATS_CMD_ATTR_TGID, tgid, baseSequence + static_cast<uint32_t>(2 * i + 1), 0);
+            samples[start + i] = TaskstatsSample{};
+            samples[start + i].pid = tgid;
+            samples[start + i].tgid = tgid;
+        }
+        if (!querySocket.send(requestBuffer)) {
+            return;
+        }
+
+        // genetlink answers synchronously inside send(), so every reply is already queued
+        replySeen.assign(count * 2, 0);
+        size_t expected = count * 2;
+        while (expected > 0) {
+            for (size_t i = 0; i < expected; ++i) {
+                replyVectors[i] = {replyBuffers.data() + i * REPLY_SIZE, REPLY_SIZE};
+                replyMessages[i] = {};
+                replyMessages[i].msg_hdr.msg_iov = &replyVectors[i];
+                replyMessages[i].msg_hdr.msg_iovlen = 1;
+            }
+            int received = recvmmsg(querySocket.fd(), replyMessages.data(), static_cast<unsigned>(expected), MSG_DONTWAIT, nullptr);
+            if (received <= 0) {
+                if (received < 0 && errno == EINTR) continue;
+                break;
+            }
+
+            for (int m = 0; m < received; ++m) {
+                auto* header = reinterpret_cast<const struct nlmsghdr*>(replyBuffers.data() + m * REPLY_SIZE);
+                if (!NLMSG_OK(header, replyMessages[m].msg_len)) continue;
+                uint32_t offset = header->nlmsg_seq - baseSequence;
+                if (offset >= count * 2 || replySeen[offset]) continue;
+                replySeen[offset] = 1;
+                --expected;
+
+                size_t slot = start + offset / 2;
+                if (header->nlmsg_type == NLMSG_ERROR) {
+                    auto* failure = static_cast<const struct nlmsgerr*>(NLMSG_DATA(header));
+                    errno = -failure->error;
+                    valid[slot] = 0;
+                    continue;
+                }
+
+                TaskstatsSample reply = {};
+                int parts = parseReply(header, reply);
+                TaskstatsSample& sample = samples[slot];
+                if (parts & HAS_GROUP) {
+                    sample.cpuTimeUs = reply.cpuTimeUs;
+                    sample.cpuDelayNs = reply.cpuDelayNs;
+                    sample.blkioDelayNs = reply.blkioDelayNs;
+                    sample.swapinDelayNs = reply.swapinDelayNs;
+                    valid[slot] = 1;
+                } else if (parts & HAS_TASK) {
+                    sample.comm = std::move(reply.comm);
+                    sample.tgid = reply.tgid;
+                    sample.startTime = reply.startTime;
+                    sample.readBytes = reply.readBytes;
+                    sample.writeBytes = reply.writeBytes;
+                }
+            }
+        }
+    }
+}
+
+int TaskstatsClient::parseReply(const struct nlmsghdr* header, TaskstatsSample& sample) const {
+    if (header->nlmsg_type != familyId || header->nlmsg_len < NLMSG_LENGTH(GENL_HDRLEN)) {
+        return 0;
+    }
+
+    int parts = 0;
+    const char* payload = static_cast<const char*>(NLMSG_DATA(header)) + GENL_HDRLEN;
+    size_t payloadLength = header->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+    forEachNetlinkAttribute(payload, payloadLength, [&](uint16_t type, const char* data, size_t size) {
+        if (type != TASKSTATS_TYPE_AGGR_PID && type != TASKSTATS_TYPE_AGGR_TGID) return;
+        bool isGroup = type == TASKSTATS_TYPE_AGGR_TGID;
+
+        forEachNetlinkAttribute(data, size, [&](uint16_t innerType, const char* innerData, size_t innerSize) {
+            if (innerType == TASKSTATS_TYPE_PID || innerType == TASKSTATS_TYPE_TGID) {
+                uint32_t id = 0;
+                memcpy(&id, innerData, std::min(innerSize, sizeof(id)));
+                if (isGroup) {
+                    sample.tgid = static_cast<int>(id);
+                } else {
+                    sample.pid = static_cast<int>(id);
+                }
+            } else if (innerType == TASKSTATS_TYPE_STATS) {
+                // the running kernel's struct may be older or newer than our header
+                struct taskstats stats = {};
+                memcpy(&stats, innerData, std::min(innerSize, sizeof(stats)));
+                if (isGroup || !(parts & HAS_GROUP)) {
+                    sample.cpuTimeUs = stats.ac_utime + stats.ac_stime;
+                    sample.cpuDelayNs = stats.cpu_delay_total;
+                    sample.blkioDelayNs = stats.blkio_delay_total;
+                    sample.swapinDelayNs = stats.swapin_delay_total;
+                }
+                if (!isGroup) {
+                    sample.comm.assign(stats.ac_comm, strnlen(stats.ac_comm, sizeof(stats.ac_comm)));
+                    sample.readBytes = stats.read_bytes;
+                    sample.writeBytes = stats.write_bytes;
+                    sample.startTime = stats.ac_btime;
+                    if (stats.ac_tgid != 0) {
+                        sample.tgid = static_cast<int>(stats.ac_tgid);
+                    }
+                }
+                parts |= isGroup ? HAS_GROUP : HAS_TASK;
+            }
+        });
+    });
+    return parts;
+}
+
+bool TaskstatsClient::listenForExits(std::string& error) {
+    if (!exitSocket.open(NETLINK_GENERIC, 0, error)) {
+        return false;
+    }
+    growReceiveBuffer(exitSocket.fd());
+
+    long cpuCount = sysconf(_SC_NPROCESSORS_CONF);
+    std::string cpuMask = "0-" + std::to_string(std::max(cpuCount, 1L) - 1);
+
+    requestBuffer.clear();
+    NetlinkMessageWriter writer(requestBuffer);
+    writer.begin(familyId, NLM_F_REQUEST | NLM_F_ACK, exitSocket.nextSequence());
+    struct genlmsghdr genl = {};
+    genl.cmd = TASKSTATS_CMD_GET;
+    genl.version = TASKSTATS_GENL_VERSION;
+    writer.appendHeader(&genl, sizeof(genl));
+    writer.addAttribute(TASKSTATS_CMD_ATTR_REGISTER_CPUMASK, cpuMask.c_str(), cpuMask.size() + 1);
+    writer.end();
+
+    if (!exitSocket.send(requestBuffer)) {
+        error = std::string("taskstats exit listener: ") + strerror(errno);
+        exitSocket.close();
+        return false;
+    }
+
+    ssize_t length = exitSocket.receive(receiveBuffer, true);
+    auto* header = reinterpret_cast<const struct nlmsghdr*>(receiveBuffer.data());
+    if (length > 0 && NLMSG_OK(header, static_cast<size_t>(length)) && header->nlmsg_type == NLMSG_ERROR) {
+        auto* ack = static_cast<const struct nlmsgerr*>(NLMSG_DATA(header));
+        if (ack->error != 0) {
+            error = std::string("taskstats exit listener: ") + strerror(-ack->error);
+            exitSocket.close();
+            return false;
+        }
+    }
+    return true;
+}
+
+int TaskstatsClient::exitFd() const {
+    return exitSocket.fd();
+}
+
+void TaskstatsClient::drainExits(std::vector<TaskstatsSample>& exited) {
+    if (!exitSocket.isOpen()) {
+        return;
+    }
+
+    while (true) {
+        ssize_t length = exitSocket.receive(receiveBuffer, false);
+        if (length <= 0) {
+            break;
+        }
+        for (auto* header = reinterpret_cast<const struct nlmsghdr*>(receiveBuffer.data());
+             NLMSG_OK(header, static_cast<size_t>(length)); header = NLMSG_NEXT(header, length)) {
+            TaskstatsSample sample = {};
+            int parts = parseReply(header, sample);
+            // the last thread of a group carries the group total; lone thread exits are skipped
+            if (parts & HAS_GROUP) {
+                sample.pid = sample.tgid;
+            } else if (!(parts & HAS_TASK) || (sample.tgid != 0 && sample.tgid != sample.pid)) {
+                continue;
+            }
+            exited.push_back(std::move(sample));
+        }
+    }
+}
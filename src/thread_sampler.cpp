@@ -0,0 +1,91 @@
+#include "../include/thread_sampler.h"
+#include <algorithm>
+#include <dirent.h>
+#include <functional>
+#include "../include/proc_io.h"
+#include "../include/proc_parsers.h"
+#include "../include/self_stats.h"
+
+ThreadSampler::ThreadSampler(std::shared_ptr<StringPool> names, long clockTicks)
+    : names(std::move(names)), clockTicks(clockTicks), deltas(MAX_DELTA_BYTES) {}
+
+void ThreadSampler::sample(const std::vector<int>& pids, std::chrono::steady_clock::time_point now,
+                           std::vector<ThreadInfo>& threads, std::vector<ThreadGroup>& groups) {
+    threads.clear();
+    groups.clear();
+    // one last pass after the final collapse drops the leftover per-thread state
+    if (pids.empty() && deltas.stats().size == 0) {
+        return;
+    }
+
+    deltas.beginGeneration();
+    for (int pid : pids) {
+        size_t first = threads.size();
+        sampleProcess(pid, now, threads);
+        if (threads.size() == first) {
+            continue;
+        }
+        std::sort(threads.begin() + first, threads.end(),
+                  [](const ThreadInfo& a, const ThreadInfo& b) { return a.cpuUsage > b.cpuUsage; });
+        groups.push_back({pid, static_cast<uint32_t>(first), static_cast<uint32_t>(threads.size() - first)});
+    }
+    deltas.evictStale();
+}
+
+void ThreadSampler::sampleProcess(int pid, std::chrono::steady_clock::time_point now, std::vector<ThreadInfo>& threads) {
+    path = "/proc/" + std::to_string(pid) + "/task";
+    DIR* taskDir = opendir(path.c_str());
+    if (taskDir == nullptr) {
+        return;
+    }
+    countFileOpen();
+
+    size_t baseLength = path.size();
+    struct dirent* entry;
+    while ((entry = readdir(taskDir)) != nullptr) {
+        int tid;
+        if (!parsePid(entry->d_name, tid)) {
+            continue;
+        }
+
+        path.resize(baseLength);
+        path += '/';
+        path += entry->d_name;
+        path += "/stat";
+        int fd = openProcFile(path);
+        if (fd < 0) {
+            continue;
+        }
+        auto content = readProcFile(fd, buffer);
+        closeProcFile(fd);
+        ProcStat stat;
+        if (!content || !parseProcStat(*content, stat)) {
+            continue;
+        }
+
+        ThreadInfo info{tid, StringPool::EMPTY_ID, stat.state, 0.0};
+        unsigned long long cpuTimeUs = (stat.utime + stat.stime) * 1000000ULL / static_cast<unsigned long long>(clockTicks);
+        bool inserted = false;
+        ProcessDelta* last = deltas.findOrInsert(tid, stat.startTime, inserted);
+        if (last) {
+            if (!inserted) {
+                double elapsedUs = std::chrono::duration<double, std::micro>(now - last->counters.time).count();
+                if (elapsedUs > 0) {
+                    info.cpuUsage = (cpuTimeUs - last->counters.cpuTimeUs) / elapsedUs * 100.0;
+                }
+            }
+            size_t commHash = std::hash<std::string_view>()(stat.comm);
+            if (inserted || commHash != last->commHash) {
+                last->nameId = names->intern(stat.comm);
+                last->commHash = commHash;
+            }
+            info.nameId = last->nameId;
+            last->counters = {cpuTimeUs, 0, 0, 0, now};
+        } else {
+            info.nameId = names->intern(stat.comm);
+        }
+        threads.push_back(info);
+    }
+
+    closedir(taskDir);
+}
@@ -0,0 +1,77 @@
+#include "../include/worker_pool.h"
+
+WorkerPool::WorkerPool(size_t threadCount)
+    : currentTask(nullptr), currentTally(nullptr), taskCount(0), nextIndex(0), activeWorkers(0), batch(0), stopping(false) {
+    for (size_t i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void WorkerPool::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (workers.empty() || count <= 1) {
+        for (size_t i = 0; i < count; ++i) task(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentTask = &task;
+        currentTally = currentIoTally;
+        taskCount = count;
+        nextIndex = 0;
+        activeWorkers = workers.size();
+        ++batch;
+    }
+    workAvailable.notify_all();
+
+    runTasks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [this] { return activeWorkers == 0; });
+    currentTask = nullptr;
+}
+
+size_t WorkerPool::size() const {
+    return workers.size() + 1;
+}
+
+void WorkerPool::workerLoop() {
+    unsigned long long seenBatch = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [&] { return stopping || batch != seenBatch; });
+            if (stopping) return;
+            seenBatch = batch;
+            currentIoTally = currentTally;
+        }
+
+        runTasks();
+        currentIoTally = nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--activeWorkers == 0) {
+                workDone.notify_one();
+            }
+        }
+    }
+}
+
+void WorkerPool::runTasks() {
+    size_t index;
+    while ((index = nextIndex.fetch_add(1)) < taskCount) {
+        (*currentTask)(index);
+    }
+}